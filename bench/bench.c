@@ -0,0 +1,366 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#include "include.h"
+
+#include <glob.h>
+
+#define BENCH_DATABASE "bench.db"
+#define BENCH_RUNS	   5
+
+// all supported frame IDs
+static const frame_type_t frame_types[] = {
+	FRAME_BSI_COMMAND,
+	FRAME_BSI_FAST,
+	FRAME_BSI_SLOW,
+	FRAME_TEMP_LEVEL,
+	FRAME_TRIP_GENERAL,
+	FRAME_TRIP_DATA_1,
+	FRAME_TRIP_DATA_2,
+};
+
+#define FRAME_TYPES	 (sizeof(frame_types) / sizeof(*frame_types))
+#define FRAME_COUNT	 4096
+#define RECORD_COUNT 1024
+
+static struct can_frame can_frames[FRAME_TYPES][FRAME_COUNT];
+static frame_t frames[FRAME_COUNT];
+static record_t records[RECORD_COUNT];
+static volatile unsigned long long sink;
+
+static unsigned long long bench_seed = 1;
+
+static unsigned int bench_rand() {
+	// xorshift64 - stable across platforms and runs
+	bench_seed ^= bench_seed << 13;
+	bench_seed ^= bench_seed >> 7;
+	bench_seed ^= bench_seed << 17;
+	return (unsigned int)bench_seed;
+}
+
+static unsigned long long bench_time_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int bench_compare(const void *a, const void *b) {
+	unsigned long long x = *(const unsigned long long *)a;
+	unsigned long long y = *(const unsigned long long *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+ * Print a single result line: median and minimum time per operation of all runs.
+ */
+static void bench_report(const char *name, unsigned long long ops, unsigned long long *times, int runs) {
+	qsort(times, runs, sizeof(*times), bench_compare);
+	double median = (double)times[runs / 2] / ops;
+	double best	  = (double)times[0] / ops;
+	printf(
+		"bench=%s ops=%llu runs=%d ns_op=%.2f ns_op_min=%.2f ops_s=%.0f\n",
+		name,
+		ops,
+		runs,
+		median,
+		best,
+		1e9 / median
+	);
+	fflush(stdout);
+}
+
+static void bench_generate() {
+	for (unsigned int t = 0; t < FRAME_TYPES; t++) {
+		for (unsigned int i = 0; i < FRAME_COUNT; i++) {
+			struct can_frame *can_frame = &can_frames[t][i];
+			can_frame->can_id			= frame_types[t];
+			can_frame->can_dlc			= 8;
+			for (unsigned int j = 0; j < 8; j++) {
+				can_frame->data[j] = bench_rand();
+			}
+		}
+	}
+	// a realistic mix of frames: mostly BSI_FAST
+	for (unsigned int i = 0; i < FRAME_COUNT; i++) {
+		unsigned int t = bench_rand() % 4 == 0 ? bench_rand() % FRAME_TYPES : 1;
+		frame_parse(&can_frames[t][i], &frames[i]);
+	}
+	// one record per minute, driving at ~50 km/h
+	unsigned long long time = 1700000000000ULL;
+	double mileage			= 10000.0;
+	for (unsigned int i = 0; i < RECORD_COUNT; i++) {
+		record_t *record = &records[i];
+		record_reset(record);
+		record->start.time	  = time;
+		record->end.time	  = time + 60 * 1000;
+		record->start.mileage = mileage;
+		record->end.mileage	  = mileage + 0.8;
+		record->dist		  = 80000 + bench_rand() % 10000;
+		record->fuel		  = 50000 + bench_rand() % 20000;
+		measurement_append(&record->engine_speed, 1500 + bench_rand() % 1500);
+		measurement_append(&record->vehicle_speed, 30 + bench_rand() % 40);
+		measurement_append(&record->coolant_temp, 90);
+		measurement_append(&record->outside_temp, 15);
+		measurement_append(&record->oil_temp, 95);
+		measurement_append(&record->oil_level, 80);
+		measurement_append(&record->fuel_level, 50);
+		measurement_append(&record->fuel_range, 400);
+		measurement_append(&record->fuel_cons, 4 + bench_rand() % 6);
+		time += 60 * 1000;
+		mileage += 0.8;
+	}
+}
+
+static void bench_frame_parse() {
+	unsigned long long times[BENCH_RUNS];
+	char name[32];
+	for (unsigned int t = 0; t < FRAME_TYPES; t++) {
+		frame_t frame;
+		for (int run = 0; run < BENCH_RUNS; run++) {
+			unsigned long long start = bench_time_ns();
+			for (int rep = 0; rep < 64; rep++) {
+				for (unsigned int i = 0; i < FRAME_COUNT; i++) {
+					sink += frame_parse(&can_frames[t][i], &frame);
+				}
+			}
+			times[run] = bench_time_ns() - start;
+		}
+		snprintf(name, sizeof(name), "frame_parse/0x%03X", frame_types[t]);
+		bench_report(name, 64 * FRAME_COUNT, times, BENCH_RUNS);
+	}
+}
+
+static void bench_record_append(bool rules) {
+	unsigned long long times[BENCH_RUNS];
+	record_t record = {0};
+	alert_reset();
+	for (int signal = 0; rules && signal < ALERT_SIGNAL_MAX; signal++) {
+		// a full table of every signal - thresholds and rates, none of them ever raised
+		for (int i = 0; i < ALERT_SIGNAL_RULES; i++) {
+			char line[128];
+			snprintf(
+				line,
+				sizeof(line),
+				"bench%d_%d %s %s 1e9 hysteresis=1 debounce=1000",
+				signal,
+				i,
+				alert_signal_name(signal),
+				i % 2 ? "fall" : "above"
+			);
+			alert_add(line);
+		}
+	}
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		record_reset(&record);
+		unsigned long long start = bench_time_ns();
+		for (int rep = 0; rep < 64; rep++) {
+			for (unsigned int i = 0; i < FRAME_COUNT; i++) {
+				record_append(&record, &frames[i]);
+			}
+		}
+		times[run] = bench_time_ns() - start;
+	}
+	sink += record.dist;
+	alert_reset();
+	bench_report(rules ? "record_append/rules" : "record_append", 64 * FRAME_COUNT, times, BENCH_RUNS);
+}
+
+static void bench_measurement_append() {
+	unsigned long long times[BENCH_RUNS];
+	measurement_t meas = {0};
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		unsigned long long start = bench_time_ns();
+		for (unsigned int i = 0; i < 64 * FRAME_COUNT; i++) {
+			measurement_append(&meas, (double)(i & 0xFF));
+		}
+		times[run] = bench_time_ns() - start;
+	}
+	sink += meas.count;
+	bench_report("measurement_append", 64 * FRAME_COUNT, times, BENCH_RUNS);
+}
+
+static void bench_trip_append() {
+	unsigned long long times[BENCH_RUNS];
+	trip_t trip = {0};
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		trip_reset(&trip);
+		unsigned long long start = bench_time_ns();
+		for (int rep = 0; rep < 64; rep++) {
+			for (unsigned int i = 0; i < RECORD_COUNT; i++) {
+				trip_append(&trip, &records[i]);
+			}
+		}
+		times[run] = bench_time_ns() - start;
+	}
+	sink += trip.dist;
+	bench_report("trip_append", 64 * RECORD_COUNT, times, BENCH_RUNS);
+}
+
+static unsigned long long bench_clock_gettimeofday() {
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (unsigned long long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static unsigned long long bench_clock_monotonic() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static unsigned long long bench_clock_now_ms() {
+	return clock_now_ms();
+}
+
+static void bench_clock(const char *name, unsigned long long (*func)()) {
+	unsigned long long times[BENCH_RUNS];
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		unsigned long long start = bench_time_ns();
+		for (unsigned int i = 0; i < 256 * FRAME_COUNT; i++) {
+			sink += func();
+		}
+		times[run] = bench_time_ns() - start;
+	}
+	bench_report(name, 256 * FRAME_COUNT, times, BENCH_RUNS);
+}
+
+static bool bench_db_open() {
+	// including record partitions (bench-<period>.db)
+	glob_t files;
+	if (glob("bench*.db*", 0, NULL, &files) == 0) {
+		for (size_t i = 0; i < files.gl_pathc; i++) {
+			unlink(files.gl_pathv[i]);
+		}
+		globfree(&files);
+	}
+	return db_connect(BENCH_DATABASE) != NULL;
+}
+
+static void bench_db_save_record(unsigned int count) {
+	unsigned long long times[BENCH_RUNS];
+	char name[32];
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		if (!bench_db_open())
+			return;
+		unsigned long long start = bench_time_ns();
+		for (unsigned int i = 0; i < count; i++) {
+			db_save_record(&records[i % RECORD_COUNT]);
+		}
+		db_wait();
+		times[run] = bench_time_ns() - start;
+		db_close();
+	}
+	snprintf(name, sizeof(name), "db_save_record/%u", count);
+	bench_report(name, count, times, BENCH_RUNS);
+}
+
+static bool bench_db_backlog(unsigned int count) {
+	// insert unprocessed records directly, in a single transaction
+	sqlite3 *db		= db_connect(BENCH_DATABASE);
+	const char *sql = (
+		"INSERT INTO record ("
+		"start_time, end_time, start_mileage, end_mileage, dist, fuel, "
+		"engine_speed, engine_speed_max, vehicle_speed_min, vehicle_speed_max, "
+		"coolant_temp, outside_temp, oil_temp, oil_level, fuel_level, fuel_range, fuel_cons_min, fuel_cons_max"
+		") VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);"
+	);
+	sqlite3_stmt *stmt = NULL;
+	bool ret		   = false;
+	if (sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(BEGIN)", goto cleanup);
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+	for (unsigned int i = 0; i < count; i++) {
+		record_t *record = &records[i % RECORD_COUNT];
+		// every RECORD_COUNT records start a new trip, an hour later
+		long long offset = (long long)(i / RECORD_COUNT) * (RECORD_COUNT + 60) * 60 * 1000;
+		sqlite3_bind_int64(stmt, 1, (long long)record->start.time + offset);
+		sqlite3_bind_int64(stmt, 2, (long long)record->end.time + offset);
+		db_bind_scaled(stmt, 3, record->start.mileage, start_mileage);
+		db_bind_scaled(stmt, 4, record->end.mileage, end_mileage);
+		sqlite3_bind_int(stmt, 5, (int)record->dist);
+		sqlite3_bind_int(stmt, 6, (int)record->fuel);
+		db_bind_scaled(stmt, 7, record->engine_speed.avg, engine_speed);
+		db_bind_scaled(stmt, 8, record->engine_speed.max, engine_speed_max);
+		db_bind_scaled(stmt, 9, record->vehicle_speed.min, vehicle_speed_min);
+		db_bind_scaled(stmt, 10, record->vehicle_speed.max, vehicle_speed_max);
+		db_bind_scaled(stmt, 11, record->coolant_temp.avg, coolant_temp);
+		db_bind_scaled(stmt, 12, record->outside_temp.avg, outside_temp);
+		db_bind_scaled(stmt, 13, record->oil_temp.avg, oil_temp);
+		db_bind_scaled(stmt, 14, record->oil_level.avg, oil_level);
+		db_bind_scaled(stmt, 15, record->fuel_level.avg, fuel_level);
+		db_bind_scaled(stmt, 16, record->fuel_range.avg, fuel_range);
+		db_bind_scaled(stmt, 17, record->fuel_cons.min, fuel_cons_min);
+		db_bind_scaled(stmt, 18, record->fuel_cons.max, fuel_cons_max);
+		if (sqlite3_step(stmt) != SQLITE_DONE)
+			SQLITE3_ERROR("sqlite3_step()", goto cleanup);
+		sqlite3_reset(stmt);
+	}
+	ret = true;
+
+cleanup:
+	sqlite3_finalize(stmt);
+	sqlite3_exec(db, ret ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL);
+	return ret;
+}
+
+static void bench_db_process_trips(unsigned int count) {
+	unsigned long long times[BENCH_RUNS];
+	char name[32];
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		if (!bench_db_open() || !bench_db_backlog(count))
+			return;
+		unsigned long long start = bench_time_ns();
+		db_process_trips();
+		db_wait();
+		times[run] = bench_time_ns() - start;
+		db_close();
+	}
+	snprintf(name, sizeof(name), "db_process_trips/%u", count);
+	bench_report(name, count, times, BENCH_RUNS);
+}
+
+int main(int argc, char *argv[]) {
+	// only print benchmark results - the logger writes to stdout too, so even warnings (i.e. of an unsynchronized
+	// clock) would break the machine-readable output
+	lt_log_configure("*=E");
+	// run only benchmarks whose name starts with the argument
+	const char *filter = argc > 1 ? argv[1] : "";
+
+	bench_generate();
+
+	if (strncmp("frame_parse", filter, strlen(filter)) == 0)
+		bench_frame_parse();
+	if (strncmp("record_append", filter, strlen(filter)) == 0) {
+		bench_record_append(false);
+		bench_record_append(true);
+	}
+	if (strncmp("measurement_append", filter, strlen(filter)) == 0)
+		bench_measurement_append();
+	if (strncmp("trip_append", filter, strlen(filter)) == 0)
+		bench_trip_append();
+	if (strncmp("clock", filter, strlen(filter)) == 0) {
+		bench_clock("clock/gettimeofday", bench_clock_gettimeofday);
+		bench_clock("clock/monotonic", bench_clock_monotonic);
+		bench_clock("clock/mono_ms", clock_mono_ms);
+		bench_clock("clock/now_ms", bench_clock_now_ms);
+	}
+	if (strncmp("db_save_record", filter, strlen(filter)) == 0) {
+		bench_db_save_record(100);
+		bench_db_save_record(1000);
+	}
+	if (strncmp("db_process_trips", filter, strlen(filter)) == 0) {
+		bench_db_process_trips(100);
+		bench_db_process_trips(1000);
+		bench_db_process_trips(10000);
+	}
+
+	// including record partitions (bench-<period>.db)
+	glob_t files;
+	if (glob("bench*.db*", 0, NULL, &files) == 0) {
+		for (size_t i = 0; i < files.gl_pathc; i++) {
+			unlink(files.gl_pathv[i]);
+		}
+		globfree(&files);
+	}
+	return 0;
+}
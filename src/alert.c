@@ -0,0 +1,236 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#include "alert.h"
+
+#define ALERT_SIGNAL_NAME(name) #name,
+static const char *alert_signal_names[] = {ALERT_SIGNALS(ALERT_SIGNAL_NAME)};
+#undef ALERT_SIGNAL_NAME
+
+static const char *alert_op_names[] = {"above", "below", "rise", "fall"};
+
+// rules of each signal - checking a decoded value costs at most ALERT_SIGNAL_RULES rules, however many are loaded
+static alert_rule_t alert_rules[ALERT_SIGNAL_MAX][ALERT_SIGNAL_RULES];
+static unsigned int alert_counts[ALERT_SIGNAL_MAX];
+
+static metric_t metric_alerts_raised METRIC_SECTION =
+	METRIC_COUNTER("triplogger_alerts_raised_total", NULL, "Alerts raised by the rules");
+static metric_t metric_alerts_active METRIC_SECTION =
+	METRIC_GAUGE("triplogger_alerts_active", NULL, "Alerts currently raised");
+
+/**
+ * Compile a single rule and add it to the table of its signal. Rules are written as:
+ *
+ *   <name> <signal> above|below|rise|fall <limit> [hysteresis=<value>] [debounce=<ms>] [window=<ms>]
+ *
+ * i.e. "coolant_hot coolant_temp above 110 hysteresis=5 debounce=3000". Limits of rise/fall rules are rates
+ * (per minute) over 'window' ms, i.e. "range_drop fuel_range fall 10 window=120000".
+ */
+bool alert_add(const char *line) {
+	char name[ALERT_NAME_SIZE], signal_name[32], op_name[8];
+	double limit;
+	int pos = 0;
+	if (sscanf(line, "%31s %31s %7s %lf%n", name, signal_name, op_name, &limit, &pos) != 4)
+		LT_ERR(W, return false, "Invalid alert rule '%s'", line);
+
+	alert_rule_t rule = {
+		.limit	= limit,
+		.window = ALERT_RATE_WINDOW,
+	};
+	strncpy2(rule.name, name, sizeof(rule.name) - 1);
+
+	alert_signal_t signal = ALERT_SIGNAL_MAX;
+	for (alert_signal_t i = 0; i < ALERT_SIGNAL_MAX; i++) {
+		if (strcmp(alert_signal_names[i], signal_name) == 0)
+			signal = i;
+	}
+	if (signal == ALERT_SIGNAL_MAX)
+		LT_ERR(W, return false, "Unknown signal '%s' of alert rule %s", signal_name, name);
+	int op = -1;
+	for (alert_op_t i = ALERT_OP_ABOVE; i <= ALERT_OP_FALL; i++) {
+		if (strcmp(alert_op_names[i], op_name) == 0)
+			op = i;
+	}
+	if (op == -1)
+		LT_ERR(W, return false, "Unknown condition '%s' of alert rule %s", op_name, name);
+	rule.op = op;
+
+	// options
+	const char *options = line + pos;
+	char key[16];
+	double value;
+	int len;
+	while (sscanf(options, " %15[a-z]=%lf%n", key, &value, &len) == 2) {
+		if (strcmp(key, "hysteresis") == 0 && value >= 0)
+			rule.hysteresis = value;
+		else if (strcmp(key, "debounce") == 0 && value >= 0)
+			rule.debounce = (unsigned int)value;
+		else if (strcmp(key, "window") == 0 && value >= 1)
+			rule.window = (unsigned int)value;
+		else
+			LT_ERR(W, return false, "Invalid option '%s' of alert rule %s", key, name);
+		options += len;
+	}
+	options += strspn(options, " \t\r\n");
+	if (*options != '\0')
+		LT_ERR(W, return false, "Invalid options '%s' of alert rule %s", options, name);
+
+	// compile all conditions to "value * sign > level" - falling rates are negative
+	switch (rule.op) {
+		case ALERT_OP_ABOVE:
+		case ALERT_OP_RISE:
+			rule.sign  = 1.0;
+			rule.level = limit;
+			break;
+		case ALERT_OP_BELOW:
+			rule.sign  = -1.0;
+			rule.level = -limit;
+			break;
+		case ALERT_OP_FALL:
+			rule.sign  = -1.0;
+			rule.level = limit;
+			break;
+	}
+
+	if (alert_counts[signal] == ALERT_SIGNAL_RULES)
+		LT_ERR(W, return false, "Too many rules of signal %s, alert rule %s ignored", signal_name, name);
+	alert_rules[signal][alert_counts[signal]++] = rule;
+	LT_DM(
+		ALERT,
+		"rule %s: %s %s %g (hysteresis %g, debounce %u ms)",
+		name,
+		signal_name,
+		op_name,
+		limit,
+		rule.hysteresis,
+		rule.debounce
+	);
+	return true;
+}
+
+/**
+ * Load rules from a file, one per line ('#' starts a comment).
+ *
+ * @return number of rules loaded, or -1 if the file can't be read
+ */
+int alert_load(const char *path) {
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		if (errno == ENOENT)
+			LT_IM(ALERT, "no rules in %s", path);
+		else
+			LT_WM(ALERT, "cannot open %s: %s", path, strerror(errno));
+		return -1;
+	}
+	int count = 0;
+	char line[256];
+	while (fgets(line, sizeof(line), file) != NULL) {
+		line[strcspn(line, "#\r\n")] = '\0';
+		if (line[strspn(line, " \t")] == '\0')
+			continue;
+		if (alert_add(line))
+			count++;
+	}
+	fclose(file);
+	LT_IM(ALERT, "loaded %d rules from %s", count, path);
+	return count;
+}
+
+void alert_reset() {
+	memset(alert_rules, 0, sizeof(alert_rules));
+	memset(alert_counts, 0, sizeof(alert_counts));
+	metric_set(&metric_alerts_active, 0);
+}
+
+static void alert_emit(alert_rule_t *rule, alert_signal_t signal, double value, unsigned long long now) {
+	alert_t alert = {
+		.signal = signal,
+		.active = rule->active,
+		.time	= now,
+		.value	= value,
+		.limit	= rule->limit,
+	};
+	memcpy(alert.rule, rule->name, sizeof(alert.rule));
+
+	if (alert.active) {
+		LT_WM(
+			ALERT,
+			"%s raised: %s %s %g (%g)",
+			rule->name,
+			alert_signal_names[signal],
+			alert_op_names[rule->op],
+			rule->limit,
+			value
+		);
+		metric_inc(&metric_alerts_raised);
+		metric_inc(&metric_alerts_active);
+	} else {
+		LT_IM(ALERT, "%s cleared", rule->name);
+		metric_dec(&metric_alerts_active);
+	}
+	db_save_alert(&alert);
+	live_alert(&alert);
+}
+
+static void alert_update(alert_rule_t *rule, alert_signal_t signal, double value, unsigned long long now) {
+	// raised above 'level', cleared only below 'level - hysteresis'
+	double x	= value * rule->sign;
+	bool active = rule->active ? x >= rule->level - rule->hysteresis : x > rule->level;
+	if (active == rule->active) {
+		rule->since = 0;
+		return;
+	}
+	// the condition must hold for 'debounce' ms, without a single value going back
+	if (rule->since == 0)
+		rule->since = now;
+	if (now - rule->since < rule->debounce)
+		return;
+	rule->active = active;
+	rule->since	 = 0;
+	alert_emit(rule, signal, value, now);
+}
+
+/**
+ * Check a decoded value against the rules of its signal.
+ */
+void alert_check(alert_signal_t signal, double value, unsigned long long now) {
+	alert_rule_t *rules = alert_rules[signal];
+	for (unsigned int i = 0; i < alert_counts[signal]; i++) {
+		alert_rule_t *rule = &rules[i];
+		if (rule->op < ALERT_OP_RISE) {
+			alert_update(rule, signal, value, now);
+			continue;
+		}
+		// rate of change between the first values of consecutive windows
+		unsigned long long elapsed = now - rule->ref_time;
+		if (rule->ref_time != 0 && elapsed < rule->window)
+			continue;
+		if (rule->ref_time != 0 && elapsed < 2ULL * rule->window)
+			// a longer gap (i.e. the engine was off) only starts a new window
+			alert_update(rule, signal, (value - rule->ref_value) * 60000.0 / elapsed, now);
+		rule->ref_time	= now;
+		rule->ref_value = value;
+	}
+}
+
+/**
+ * Clear all raised alerts, i.e. when stopping - their state is not kept across restarts.
+ */
+void alert_clear_all(unsigned long long now) {
+	for (alert_signal_t signal = 0; signal < ALERT_SIGNAL_MAX; signal++) {
+		for (unsigned int i = 0; i < alert_counts[signal]; i++) {
+			alert_rule_t *rule = &alert_rules[signal][i];
+			rule->since		   = 0;
+			rule->ref_time	   = 0;
+			if (!rule->active)
+				continue;
+			rule->active = false;
+			alert_emit(rule, signal, NAN, now);
+		}
+	}
+}
+
+const char *alert_signal_name(alert_signal_t signal) {
+	if (signal >= ALERT_SIGNAL_MAX)
+		return "unknown";
+	return alert_signal_names[signal];
+}
@@ -0,0 +1,63 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#pragma once
+
+#include "include.h"
+
+#define ALERT_NAME_SIZE 32
+
+// signals that rules can watch - named after the measurement_t fields of record_t
+#define ALERT_SIGNALS(X)                                                                                               \
+	X(engine_speed) X(vehicle_speed) X(coolant_temp) X(outside_temp) X(oil_temp) X(oil_level) X(fuel_level)            \
+		X(fuel_cons) X(fuel_range)
+
+#define ALERT_SIGNAL_ENUM(name) ALERT_SIGNAL_##name,
+typedef enum alert_signal_t {
+	ALERT_SIGNALS(ALERT_SIGNAL_ENUM) ALERT_SIGNAL_MAX,
+} alert_signal_t;
+#undef ALERT_SIGNAL_ENUM
+
+typedef enum alert_op_t {
+	ALERT_OP_ABOVE, //!< Value above the limit
+	ALERT_OP_BELOW, //!< Value below the limit
+	ALERT_OP_RISE,	//!< Value rising faster than the limit (per minute)
+	ALERT_OP_FALL,	//!< Value falling faster than the limit (per minute)
+} alert_op_t;
+
+/**
+ * A rule, compiled into the table of its signal.
+ */
+typedef struct alert_rule_t {
+	char name[ALERT_NAME_SIZE]; //!< Rule name, stored with its alerts
+	alert_op_t op;
+	double limit;		   //!< Limit, as configured
+	double sign;		   //!< -1 for BELOW/FALL rules, which compare negated values against 'level'
+	double level;		   //!< Value (multiplied by 'sign') above which the alert is raised
+	double hysteresis;	   //!< How far below 'level' the value must go to clear the alert
+	unsigned int debounce; //!< How long the condition must hold before raising/clearing the alert (ms)
+	unsigned int window;   //!< Interval of calculating the rate of change (ms, RISE/FALL only)
+
+	bool active;				 //!< Whether the alert is raised
+	unsigned long long since;	 //!< Time the condition started to differ from 'active' (0 if it doesn't)
+	unsigned long long ref_time; //!< Start of the current rate window (RISE/FALL only)
+	double ref_value;			 //!< Value at the start of the current rate window
+} alert_rule_t;
+
+/**
+ * An alert being raised or cleared.
+ */
+typedef struct alert_t {
+	char rule[ALERT_NAME_SIZE];
+	alert_signal_t signal;
+	bool active;			 //!< Raised (true) or cleared (false)
+	unsigned long long time; //!< Time of raising/clearing (clock_mono_ms())
+	double value;			 //!< Value (rate per minute for RISE/FALL) that raised/cleared the alert
+	double limit;			 //!< Limit of the rule
+} alert_t;
+
+bool alert_add(const char *line);
+int alert_load(const char *path);
+void alert_reset();
+void alert_check(alert_signal_t signal, double value, unsigned long long now);
+void alert_clear_all(unsigned long long now);
+const char *alert_signal_name(alert_signal_t signal);
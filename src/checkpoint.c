@@ -0,0 +1,168 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#include "checkpoint.h"
+
+#include <stddef.h>
+#include <sys/mman.h>
+
+_Static_assert(sizeof(checkpoint_file_t) == 3 * CHECKPOINT_PAGE_SIZE, "checkpoint_file_t layout");
+_Static_assert(sizeof(record_t) <= sizeof(((checkpoint_slot_t *)0)->data), "record_t too large to checkpoint");
+
+typedef struct checkpoint_trip_t {
+	trip_t trip;
+	long long rowid; //!< Last record appended to the trip
+} checkpoint_trip_t;
+
+_Static_assert(sizeof(checkpoint_trip_t) <= sizeof(((checkpoint_slot_t *)0)->data), "trip_t too large to checkpoint");
+
+static checkpoint_file_t *checkpoint = NULL;
+static record_t checkpoint_last		 = {0}; //!< Last checkpointed record (main thread only)
+
+static metric_t metric_checkpoint_writes METRIC_SECTION =
+	METRIC_COUNTER("triplogger_checkpoint_writes_total", NULL, "Checkpoint slot writes");
+
+static uint32_t checkpoint_crc(const checkpoint_slot_t *slot) {
+	// CRC-32 (IEEE), bitwise - slots are small and written every few seconds
+	const uint8_t *data = (const uint8_t *)slot;
+	uint32_t crc		= 0xFFFFFFFF;
+	for (size_t i = 0; i < 16 + slot->size; i++) {
+		// skip the CRC field itself
+		if (i >= offsetof(checkpoint_slot_t, crc) && i < offsetof(checkpoint_slot_t, size))
+			continue;
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+		}
+	}
+	return ~crc;
+}
+
+static void checkpoint_write(checkpoint_slot_t *slots, const void *data, uint32_t size) {
+	// overwrite the older slot, keeping the newer one intact
+	checkpoint_slot_t *newer = slots[0].generation >= slots[1].generation ? &slots[0] : &slots[1];
+	checkpoint_slot_t *slot	 = newer == &slots[0] ? &slots[1] : &slots[0];
+
+	slot->generation = newer->generation + 1;
+	slot->size		 = size;
+	memcpy(slot->data, data, size);
+	slot->crc = checkpoint_crc(slot);
+
+	// both slots share a page
+	uintptr_t page = (uintptr_t)slots & ~(uintptr_t)(CHECKPOINT_PAGE_SIZE - 1);
+	if (msync((void *)page, CHECKPOINT_PAGE_SIZE, MS_SYNC) != 0)
+		LT_WM(MAIN, "checkpoint msync() failed: %s", strerror(errno));
+	metric_inc(&metric_checkpoint_writes);
+}
+
+static bool checkpoint_read(const checkpoint_slot_t *slots, void *data, uint32_t size) {
+	const checkpoint_slot_t *found = NULL;
+	for (int i = 0; i < 2; i++) {
+		const checkpoint_slot_t *slot = &slots[i];
+		if (slot->generation == 0 || slot->size != size || slot->crc != checkpoint_crc(slot))
+			continue;
+		if (found == NULL || slot->generation > found->generation)
+			found = slot;
+	}
+	if (found == NULL)
+		return false;
+	memcpy(data, found->data, size);
+	return true;
+}
+
+bool checkpoint_open(const char *path) {
+	if (checkpoint != NULL)
+		return true;
+
+	int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd == -1)
+		LT_ERR(E, return false, "Cannot open checkpoint %s: %s", path, strerror(errno));
+	if (ftruncate(fd, sizeof(checkpoint_file_t)) != 0) {
+		LT_E("Cannot resize checkpoint %s: %s", path, strerror(errno));
+		close(fd);
+		return false;
+	}
+	checkpoint = mmap(NULL, sizeof(checkpoint_file_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (checkpoint == MAP_FAILED) {
+		checkpoint = NULL;
+		LT_ERR(E, return false, "Cannot map checkpoint %s: %s", path, strerror(errno));
+	}
+
+	if (checkpoint->magic != CHECKPOINT_MAGIC || checkpoint->version != CHECKPOINT_VERSION ||
+		checkpoint->record_size != sizeof(record_t) || checkpoint->trip_size != sizeof(trip_t)) {
+		// new file, or written by an incompatible version
+		memset(checkpoint, 0, sizeof(*checkpoint));
+		checkpoint->magic		= CHECKPOINT_MAGIC;
+		checkpoint->version		= CHECKPOINT_VERSION;
+		checkpoint->record_size = sizeof(record_t);
+		checkpoint->trip_size	= sizeof(trip_t);
+		msync(checkpoint, sizeof(*checkpoint), MS_SYNC);
+	}
+
+	LT_IM(MAIN, "checkpoint at %s", path);
+	return true;
+}
+
+void checkpoint_close() {
+	if (checkpoint == NULL)
+		return;
+	munmap(checkpoint, sizeof(*checkpoint));
+	checkpoint = NULL;
+}
+
+/**
+ * Restore the trip state and save the record checkpointed before the last shutdown.
+ * Must be called after db_connect(), before processing trips.
+ */
+void checkpoint_recover() {
+	if (checkpoint == NULL)
+		return;
+
+	checkpoint_trip_t trip;
+	if (checkpoint_read(checkpoint->trip, &trip, sizeof(trip)) && db_restore_trip(&trip.trip, trip.rowid))
+		LT_IM(MAIN, "trip restored, last record rowid = %lld", trip.rowid);
+
+	record_t record;
+	if (!checkpoint_read(checkpoint->record, &record, sizeof(record)) || record.start.time == 0)
+		return;
+	// the record was saved already, if the shutdown was clean (or the checkpoint is older)
+	if (db_has_record(record.start.time))
+		return;
+	LT_IM(MAIN, "recovering record, end time = %llu", record.end.time);
+	record.start.time = clock_mono_of(record.start.time);
+	record.end.time	  = clock_mono_of(record.end.time);
+	db_save_record(&record);
+}
+
+/**
+ * Checkpoint the current record, if it changed since the last call.
+ */
+void checkpoint_save_record(record_t *record) {
+	if (checkpoint == NULL)
+		return;
+	if (record->start.time == checkpoint_last.start.time && record->end.time == checkpoint_last.end.time)
+		return;
+	checkpoint_last = *record;
+
+	// stored with wall-clock times, monotonic time doesn't survive a reboot
+	record_t copy = *record;
+	if (copy.start.time != 0) {
+		copy.start.time = clock_wall_ms(copy.start.time);
+		copy.end.time	= clock_wall_ms(copy.end.time);
+	}
+	checkpoint_write(checkpoint->record, &copy, sizeof(copy));
+}
+
+/**
+ * Checkpoint the trip in progress. Must only be called with the database in a consistent state, i.e. when
+ * all records up to 'rowid' are either saved in a trip, or appended to 'trip'.
+ */
+void checkpoint_save_trip(trip_t *trip, long long rowid) {
+	if (checkpoint == NULL)
+		return;
+	checkpoint_trip_t data = {
+		.trip  = *trip,
+		.rowid = rowid,
+	};
+	checkpoint_write(checkpoint->trip, &data, sizeof(data));
+}
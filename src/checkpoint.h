@@ -0,0 +1,43 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#pragma once
+
+#include "include.h"
+
+#define CHECKPOINT_MAGIC	 0x50434C54 // "LTCP"
+#define CHECKPOINT_VERSION	 1
+#define CHECKPOINT_PAGE_SIZE 4096
+
+typedef struct record_t record_t;
+typedef struct trip_t trip_t;
+
+/**
+ * A single copy of checkpointed data. Every area has two slots, written alternately -
+ * if power is lost while writing one, the other one still holds the previous state.
+ */
+typedef struct checkpoint_slot_t {
+	uint64_t generation; //!< Incremented on every write, 0 if never written
+	uint32_t crc;		 //!< CRC-32 of generation, size and data
+	uint32_t size;		 //!< Size of data
+	uint8_t data[CHECKPOINT_PAGE_SIZE / 2 - 16];
+} checkpoint_slot_t;
+
+/**
+ * Layout of the checkpoint file. Each area is on its own page, so that it can be synced separately.
+ */
+typedef struct checkpoint_file_t {
+	uint32_t magic;		  //!< CHECKPOINT_MAGIC
+	uint16_t version;	  //!< CHECKPOINT_VERSION
+	uint16_t reserved;	  //!< Zero
+	uint32_t record_size; //!< sizeof(record_t) - the file is discarded if it changes
+	uint32_t trip_size;	  //!< sizeof(trip_t) - the file is discarded if it changes
+	uint8_t padding[CHECKPOINT_PAGE_SIZE - 16];
+	checkpoint_slot_t record[2]; //!< Current record (main thread), with wall-clock times
+	checkpoint_slot_t trip[2];	 //!< Current trip and its last record rowid (database thread)
+} checkpoint_file_t;
+
+bool checkpoint_open(const char *path);
+void checkpoint_close();
+void checkpoint_recover();
+void checkpoint_save_record(record_t *record);
+void checkpoint_save_trip(trip_t *trip, long long rowid);
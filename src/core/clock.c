@@ -0,0 +1,96 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#include "clock.h"
+
+#include <sys/timex.h>
+
+static pthread_once_t clock_once			= PTHREAD_ONCE_INIT;
+static atomic_llong clock_offset			= 0; //!< Wall-clock minus monotonic time (ms)
+static atomic_llong clock_pending			= 0; //!< Steps found by clock_check(), not re-anchored yet (ms)
+static unsigned long long clock_last_check	= 0; //!< Monotonic time of the last clock_check() (ms)
+static unsigned long long clock_replay_base = 0; //!< System monotonic time of the start of the replayed capture (ms)
+atomic_ullong clock_replay_now				= 0;
+
+static long long clock_realtime_offset() {
+	struct timespec mono, real;
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &mono);
+	clock_gettime(CLOCK_REALTIME_COARSE, &real);
+	long long mono_ms = (long long)mono.tv_sec * 1000 + mono.tv_nsec / 1000000;
+	long long real_ms = (long long)real.tv_sec * 1000 + real.tv_nsec / 1000000;
+	return real_ms - mono_ms;
+}
+
+static void clock_init() {
+	atomic_store(&clock_offset, clock_realtime_offset());
+	if (!clock_synced())
+		LT_WM(MAIN, "system clock not synchronized, timestamps will be adjusted later");
+}
+
+/**
+ * Convert a monotonic timestamp to wall-clock time (ms since epoch), using the current anchor.
+ */
+unsigned long long clock_wall_ms(unsigned long long mono) {
+	pthread_once(&clock_once, clock_init);
+	return mono + atomic_load_explicit(&clock_offset, memory_order_relaxed);
+}
+
+/**
+ * Convert a wall-clock timestamp back to monotonic time, i.e. for records restored after a restart.
+ */
+unsigned long long clock_mono_of(unsigned long long wall) {
+	pthread_once(&clock_once, clock_init);
+	return wall - atomic_load_explicit(&clock_offset, memory_order_relaxed);
+}
+
+unsigned long long clock_now_ms() {
+	return clock_wall_ms(clock_mono_ms());
+}
+
+bool clock_synced() {
+	struct timex tx = {0};
+	if (adjtimex(&tx) == -1)
+		return false;
+	return !(tx.status & STA_UNSYNC);
+}
+
+/**
+ * Check whether the wall-clock was stepped since anchoring (i.e. by NTP after boot).
+ * Only checks every CLOCK_CHECK_INTERVAL, so it's cheap enough to call for every frame.
+ *
+ * @return difference (ms) to pass to clock_reanchor() - it's not reported again - or 0 if the anchor is still valid
+ */
+long long clock_check() {
+	pthread_once(&clock_once, clock_init);
+	unsigned long long now = clock_mono_ms();
+	if (now - clock_last_check < CLOCK_CHECK_INTERVAL)
+		return 0;
+	clock_last_check = now;
+
+	// steps already waiting for clock_reanchor() (i.e. behind other database jobs) are not reported again
+	long long delta = clock_realtime_offset() - atomic_load(&clock_offset) - atomic_load(&clock_pending);
+	// ignore small differences (i.e. NTP slewing), and steps of an unsynchronized clock
+	if (llabs(delta) < CLOCK_STEP_THRESHOLD || !clock_synced())
+		return 0;
+	atomic_fetch_add(&clock_pending, delta);
+	return delta;
+}
+
+/**
+ * Set the time of the replayed frame (ms since the start of the capture). The capture starts at the time of
+ * the first call, then clock_mono_ms() follows the capture - no matter how fast it's replayed.
+ */
+void clock_replay(unsigned long long time) {
+	if (atomic_load(&clock_replay_now) == 0)
+		clock_replay_base = clock_system_ms() - time;
+	atomic_store(&clock_replay_now, clock_replay_base + time);
+}
+
+/**
+ * Move the anchor by 'delta' ms. Timestamps converted before should be adjusted by the same amount.
+ */
+void clock_reanchor(long long delta) {
+	pthread_once(&clock_once, clock_init);
+	atomic_fetch_add(&clock_offset, delta);
+	atomic_fetch_sub(&clock_pending, delta);
+	LT_IM(MAIN, "system clock stepped by %lld ms, timestamps adjusted", delta);
+}
@@ -0,0 +1,36 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#pragma once
+
+#include "include.h"
+
+extern atomic_ullong clock_replay_now; //!< Monotonic time of the replayed frame (ms), 0 if not replaying a capture
+
+/**
+ * Monotonic time (ms) of the system, regardless of replaying.
+ */
+static inline unsigned long long clock_system_ms() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+	return (unsigned long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Monotonic time (ms) - use for all intervals and in-memory timestamps.
+ * Coarse (a few ms resolution), but doesn't need a syscall.
+ * Follows the capture time while replaying timed captures (see clock_replay()).
+ */
+static inline unsigned long long clock_mono_ms() {
+	unsigned long long replay = atomic_load_explicit(&clock_replay_now, memory_order_relaxed);
+	if (replay != 0)
+		return replay;
+	return clock_system_ms();
+}
+
+unsigned long long clock_wall_ms(unsigned long long mono);
+unsigned long long clock_now_ms();
+unsigned long long clock_mono_of(unsigned long long wall);
+bool clock_synced();
+long long clock_check();
+void clock_reanchor(long long delta);
+void clock_replay(unsigned long long time);
@@ -15,7 +15,184 @@
 #define LT_LOGGER_COLOR 1
 #endif
 
+// Minimum level of compiled-in log calls (LT_LEVEL_*)
+#ifndef LT_LOGGER_LEVEL
+#define LT_LOGGER_LEVEL LT_LEVEL_TRACE
+#endif
+
+// Log modules compiled in (LT_xM() calls)
+#ifndef LT_DEBUG_MAIN
+#define LT_DEBUG_MAIN 1
+#endif
+
+#ifndef LT_DEBUG_DB
+#define LT_DEBUG_DB 1
+#endif
+
+#ifndef LT_DEBUG_LIVE
+#define LT_DEBUG_LIVE 1
+#endif
+
+#ifndef LT_DEBUG_FRAME
+#define LT_DEBUG_FRAME 1
+#endif
+
+#ifndef LT_DEBUG_RECORD
+#define LT_DEBUG_RECORD 1
+#endif
+
+#ifndef LT_DEBUG_TRIP
+#define LT_DEBUG_TRIP 1
+#endif
+
+#ifndef LT_DEBUG_POWER
+#define LT_DEBUG_POWER 1
+#endif
+
+#ifndef LT_DEBUG_ALERT
+#define LT_DEBUG_ALERT 1
+#endif
+
+// Logger queue options
+#ifndef LT_LOGGER_QUEUE_SIZE
+#define LT_LOGGER_QUEUE_SIZE 256 // number of lines, power of 2
+#endif
+
+#ifndef LT_LOGGER_LINE_SIZE
+#define LT_LOGGER_LINE_SIZE 512 // max. length of a single line
+#endif
+
+// Binary trace options - log calls only store their raw arguments
+#ifndef LT_LOGGER_TRACE
+#define LT_LOGGER_TRACE 0
+#endif
+
+#ifndef LT_TRACE_FILE
+#define LT_TRACE_FILE "canlogger.trace"
+#endif
+
+#ifndef LT_TRACE_SIZE
+#define LT_TRACE_SIZE (4 * 1024 * 1024) // ring size in bytes, power of 2
+#endif
+
+#ifndef LT_TRACE_MAX_ARGS
+#define LT_TRACE_MAX_ARGS 16 // max. number of arguments of a single call
+#endif
+
+#ifndef LT_TRACE_STR_MAX
+#define LT_TRACE_STR_MAX 128 // max. stored length of a string argument
+#endif
+
+// Abort on heap allocations of the ingest path after warm-up (test builds only)
+#ifndef MALLOC_GUARD
+#define MALLOC_GUARD 0
+#endif
+
+#ifndef MALLOC_GUARD_WARMUP
+#define MALLOC_GUARD_WARMUP 2 // records saved before the guard is armed
+#endif
+
+// Interval of checking whether the system clock was stepped (ms)
+#ifndef CLOCK_CHECK_INTERVAL
+#define CLOCK_CHECK_INTERVAL 10000
+#endif
+
+// Minimum clock step that re-anchors stored timestamps (ms)
+#ifndef CLOCK_STEP_THRESHOLD
+#define CLOCK_STEP_THRESHOLD 1000
+#endif
+
+// Interval of the main loop timer - idle and clock checks (ms)
+#ifndef TIMER_INTERVAL
+#define TIMER_INTERVAL 1000
+#endif
+
+// Interval of the main loop timer in standby - still closes trips after TRIP_GAP_TIME (ms)
+#ifndef STANDBY_TIMER_INTERVAL
+#define STANDBY_TIMER_INTERVAL 60000
+#endif
+
+// Bus silence after which the current record is saved (ms)
+#ifndef BUS_IDLE_TIMEOUT
+#define BUS_IDLE_TIMEOUT 5000
+#endif
+
+// Gap between records that ends a trip (ms)
+#ifndef TRIP_GAP_TIME
+#define TRIP_GAP_TIME (5 * 60 * 1000)
+#endif
+
+// CAN interface to read frames from (if not given on the command line)
+#ifndef CAN_INTERFACE
+#define CAN_INTERFACE "can0"
+#endif
+
 // Database path
 #ifndef DATABASE_FILE
 #define DATABASE_FILE "canlogger.db"
 #endif
+
+// Period of record partition files, as a strftime() format (UTC, also used in SQL) - i.e. canlogger-2026-10.db
+#ifndef DATABASE_PARTITION
+#define DATABASE_PARTITION "%Y-%m"
+#endif
+
+// Database jobs waiting at most - the main loop waits for a free slot if the database falls behind
+#ifndef DATABASE_JOB_SLOTS
+#define DATABASE_JOB_SLOTS 32
+#endif
+
+// Completed trips saved at once when processing trips
+#ifndef DATABASE_TRIP_BATCH
+#define DATABASE_TRIP_BATCH 16
+#endif
+
+// Fixed memory of SQLite (bytes, a power of 2), so that it never calls malloc()
+#ifndef DATABASE_HEAP_SIZE
+#define DATABASE_HEAP_SIZE (8 * 1024 * 1024)
+#endif
+
+// Preallocated page cache slots, used before pages are allocated from the heap
+#ifndef DATABASE_PAGE_CACHE
+#define DATABASE_PAGE_CACHE 512
+#endif
+
+// Checkpoint of the current record and trip, for recovery after power loss
+#ifndef CHECKPOINT_FILE
+#define CHECKPOINT_FILE "canlogger.ckpt"
+#endif
+
+// Minimum interval between record checkpoints (ms)
+#ifndef CHECKPOINT_INTERVAL
+#define CHECKPOINT_INTERVAL 5000
+#endif
+
+// Alert rules, one per line (see alert_add())
+#ifndef ALERT_RULES_FILE
+#define ALERT_RULES_FILE "canlogger.rules"
+#endif
+
+// Rules of a single signal at most - bounds the work done for each decoded value
+#ifndef ALERT_SIGNAL_RULES
+#define ALERT_SIGNAL_RULES 4
+#endif
+
+// Default interval of calculating the rate of change of rise/fall rules (ms)
+#ifndef ALERT_RATE_WINDOW
+#define ALERT_RATE_WINDOW 60000
+#endif
+
+// Live telemetry socket (bound by the web server)
+#ifndef LIVE_SOCKET
+#define LIVE_SOCKET "/tmp/triplogger-live.sock"
+#endif
+
+// Minimum interval between live telemetry packets (ms)
+#ifndef LIVE_INTERVAL
+#define LIVE_INTERVAL 100
+#endif
+
+// Metrics socket (Prometheus text format, read by the web server)
+#ifndef METRICS_SOCKET
+#define METRICS_SOCKET "/tmp/triplogger-metrics.sock"
+#endif
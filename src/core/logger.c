@@ -2,6 +2,8 @@
 
 #include "logger.h"
 
+#include <stdatomic.h>
+
 #define COLOR_FMT			 "\e[0;30m"
 #define COLOR_BLACK			 0x00
 #define COLOR_RED			 0x01
@@ -22,6 +24,14 @@
 
 static const char levels[] = {'V', 'D', 'I', 'W', 'E', 'F'};
 
+#define LT_MODULE_NAME(name) #name,
+static const char *modules[] = {LT_MODULES(LT_MODULE_NAME)};
+#undef LT_MODULE_NAME
+
+uint8_t lt_log_levels[LT_MODULE_MAX] = {
+	[0 ... LT_MODULE_MAX - 1] = LT_LOGGER_LEVEL,
+};
+
 #if LT_LOGGER_COLOR
 static const uint8_t colors[] = {
 	COLOR_BRIGHT_CYAN,
@@ -33,19 +43,245 @@ static const uint8_t colors[] = {
 };
 #endif
 
-static char message_buf[1024];
+_Static_assert((LT_LOGGER_QUEUE_SIZE & (LT_LOGGER_QUEUE_SIZE - 1)) == 0, "Queue size must be a power of 2");
+
+/**
+ * A single line of the bounded MPSC queue (based on Dmitry Vyukov's algorithm).
+ * The sequence number tells whether the slot is free for the producer or ready for the writer.
+ */
+typedef struct lt_slot_t {
+	atomic_size_t seq;
+	unsigned short len;
+	char data[LT_LOGGER_LINE_SIZE];
+} lt_slot_t;
+
+static lt_slot_t queue[LT_LOGGER_QUEUE_SIZE];
+static atomic_size_t queue_head = 0; //!< Next position to write (producers)
+static size_t queue_tail		= 0; //!< Next position to read (writer thread)
+static atomic_size_t queue_done = 0; //!< Position up to which lines were written out
+static atomic_uint dropped		= 0; //!< Lines lost because the queue was full
+
+static pthread_once_t writer_once	= PTHREAD_ONCE_INIT;
+static pthread_mutex_t writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_cond	= PTHREAD_COND_INITIALIZER;
+static atomic_bool writer_idle		= false;
+static bool writer_running			= false;
+
+static long long lt_log_queue_depth();
+
+static metric_t metric_log_queue METRIC_SECTION =
+	METRIC_GAUGE_READ("triplogger_log_queue_depth", NULL, "Log lines waiting to be written", lt_log_queue_depth);
+static metric_t metric_log_dropped METRIC_SECTION =
+	METRIC_COUNTER("triplogger_log_dropped_total", NULL, "Log lines dropped because the queue was full");
+
+// formatting buffer and cached timestamp of each thread
+static __thread char line_buf[LT_LOGGER_LINE_SIZE];
+#if LT_LOGGER_TIMESTAMP
+static __thread time_t ts_sec = 0;
+static __thread char ts_buf[20];
+#endif
+
+static void lt_log_write(const char *data, size_t len) {
+	while (len) {
+		ssize_t ret = write(STDOUT_FILENO, data, len);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return;
+		data += ret;
+		len -= ret;
+	}
+}
+
+static bool lt_log_dequeue(char *buf, size_t *len) {
+	lt_slot_t *slot = &queue[queue_tail & (LT_LOGGER_QUEUE_SIZE - 1)];
+	size_t seq		= atomic_load_explicit(&slot->seq, memory_order_acquire);
+	if (seq != queue_tail + 1)
+		return false;
+	memcpy(buf, slot->data, slot->len);
+	*len = slot->len;
+	atomic_store_explicit(&slot->seq, queue_tail + LT_LOGGER_QUEUE_SIZE, memory_order_release);
+	queue_tail++;
+	return true;
+}
+
+static void *lt_log_writer(void *arg) {
+	// collect multiple lines into a single write(), with room for the dropped lines notice after them
+	static char out[LT_LOGGER_LINE_SIZE * 16 + 64];
+	while (1) {
+		size_t out_len = 0;
+		size_t len;
+		while (out_len + LT_LOGGER_LINE_SIZE <= LT_LOGGER_LINE_SIZE * 16 && lt_log_dequeue(out + out_len, &len))
+			out_len += len;
+
+		unsigned int lost = atomic_exchange(&dropped, 0);
+		if (lost) {
+			int ret = snprintf(out + out_len, sizeof(out) - out_len, "W logger: dropped %u line(s)\r\n", lost);
+			// snprintf() returns the untruncated length
+			out_len += min((size_t)max(ret, 0), sizeof(out) - out_len - 1);
+		}
+
+		if (out_len) {
+			lt_log_write(out, out_len);
+			atomic_store(&queue_done, queue_tail);
+			continue;
+		}
+
+		// queue is empty - wait for producers
+		pthread_mutex_lock(&writer_mutex);
+		atomic_store(&writer_idle, true);
+		struct timespec ts;
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += 100 * 1000 * 1000;
+		if (ts.tv_nsec >= 1000 * 1000 * 1000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000 * 1000 * 1000;
+		}
+		pthread_cond_timedwait(&writer_cond, &writer_mutex, &ts);
+		atomic_store(&writer_idle, false);
+		pthread_mutex_unlock(&writer_mutex);
+	}
+	return NULL;
+}
+
+static void lt_log_start() {
+	for (size_t i = 0; i < LT_LOGGER_QUEUE_SIZE; i++) {
+		atomic_init(&queue[i].seq, i);
+	}
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, lt_log_writer, NULL) != 0)
+		return;
+	pthread_detach(thread);
+	writer_running = true;
+	atexit(lt_log_flush);
+}
+
+static void lt_log_enqueue(const char *data, size_t len) {
+	if (!writer_running) {
+		// no writer thread - write synchronously
+		lt_log_write(data, len);
+		return;
+	}
+	size_t pos = atomic_load_explicit(&queue_head, memory_order_relaxed);
+	lt_slot_t *slot;
+	while (1) {
+		slot	   = &queue[pos & (LT_LOGGER_QUEUE_SIZE - 1)];
+		size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+		intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit(
+					&queue_head,
+					&pos,
+					pos + 1,
+					memory_order_relaxed,
+					memory_order_relaxed
+				))
+				break;
+		} else if (diff < 0) {
+			// queue is full - never block the caller
+			atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+			metric_inc(&metric_log_dropped);
+			return;
+		} else {
+			pos = atomic_load_explicit(&queue_head, memory_order_relaxed);
+		}
+	}
+	memcpy(slot->data, data, len);
+	slot->len = len;
+	atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+	if (atomic_load_explicit(&writer_idle, memory_order_relaxed))
+		pthread_cond_signal(&writer_cond);
+}
+
+static long long lt_log_queue_depth() {
+	return atomic_load(&queue_head) - atomic_load(&queue_done);
+}
+
+void lt_log_flush() {
+	if (!writer_running)
+		return;
+	// wait until the writer thread empties the queue
+	size_t head = atomic_load(&queue_head);
+	for (int i = 0; i < 1000; i++) {
+		if ((intptr_t)(atomic_load(&queue_done) - head) >= 0)
+			return;
+		pthread_cond_signal(&writer_cond);
+		usleep(1000);
+	}
+}
+
+void lt_log_set_level(lt_module_t module, uint8_t level) {
+	if (module >= LT_MODULE_MAX)
+		return;
+	lt_log_levels[module] = level;
+}
+
+void lt_log_configure(const char *config) {
+	// parse a list of MODULE=LEVEL entries, i.e. "DB=W,FRAME=D"; "*" matches all modules
+	if (config == NULL)
+		return;
+	while (*config) {
+		size_t len		= strcspn(config, ",");
+		const char *sep = memchr(config, '=', len);
+		if (sep != NULL && sep + 1 < config + len) {
+			size_t name_len = sep - config;
+			const char *pos = memchr(levels, sep[1] == 'T' ? 'V' : sep[1], sizeof(levels));
+			if (pos == NULL) {
+				LT_W("Unknown log level '%c'", sep[1]);
+			} else {
+				bool found = false;
+				for (lt_module_t module = 0; module < LT_MODULE_MAX; module++) {
+					bool all   = name_len == 1 && *config == '*';
+					bool match = strlen(modules[module]) == name_len && strncmp(modules[module], config, name_len) == 0;
+					if (all || match) {
+						lt_log_set_level(module, pos - levels);
+						found = true;
+					}
+				}
+				if (!found)
+					LT_W("Unknown log module '%.*s'", (int)name_len, config);
+			}
+		}
+		config += len;
+		if (*config == ',')
+			config++;
+	}
+}
 
 #if LT_LOGGER_CALLER
 void lt_log(const uint8_t level, const char *caller, const unsigned short line, const char *format, ...) {
+	va_list va_args;
+	va_start(va_args, format);
+	lt_vlog(level, caller, line, format, va_args);
+	va_end(va_args);
+}
 #else
 void lt_log(const uint8_t level, const char *format, ...) {
+	va_list va_args;
+	va_start(va_args, format);
+	lt_vlog(level, format, va_args);
+	va_end(va_args);
+}
+#endif
+
+#if LT_LOGGER_CALLER
+void lt_vlog(const uint8_t level, const char *caller, const unsigned short line, const char *format, va_list va_args) {
+#else
+void lt_vlog(const uint8_t level, const char *format, va_list va_args) {
 #endif
+	pthread_once(&writer_once, lt_log_start);
 
 #if LT_LOGGER_TIMESTAMP
-	struct timeval tv;
-	gettimeofday(&tv, NULL);
-	time_t t	 = tv.tv_sec;
-	struct tm tm = *localtime(&t);
+	struct timespec tv;
+	clock_gettime(CLOCK_REALTIME, &tv);
+	if (tv.tv_sec != ts_sec) {
+		// format the date and time only once per second
+		struct tm tm;
+		localtime_r(&tv.tv_sec, &tm);
+		strftime(ts_buf, sizeof(ts_buf), "%Y-%m-%d %H:%M:%S", &tm);
+		ts_sec = tv.tv_sec;
+	}
 #endif
 
 #if LT_LOGGER_COLOR
@@ -53,14 +289,16 @@ void lt_log(const uint8_t level, const char *format, ...) {
 	char c_value  = '0' + (colors[level] & 0x7);
 #endif
 
-	printf(
+	int len = snprintf(
+		line_buf,
+		sizeof(line_buf),
 	// format:
 #if LT_LOGGER_COLOR
 		"\x1B[%c;3%cm"
 #endif
 		"%c "
 #if LT_LOGGER_TIMESTAMP
-		"[%04d-%02d-%02d %02d:%02d:%02d.%03d] "
+		"[%s.%03d] "
 #endif
 #if LT_LOGGER_COLOR
 		"\x1B[0m"
@@ -77,13 +315,8 @@ void lt_log(const uint8_t level, const char *format, ...) {
 		levels[level]
 #if LT_LOGGER_TIMESTAMP
 		,
-		tm.tm_year + 1900,
-		tm.tm_mon + 1,
-		tm.tm_mday,
-		tm.tm_hour,
-		tm.tm_min,
-		tm.tm_sec,
-		(int)(tv.tv_usec / 1000)
+		ts_buf,
+		(int)(tv.tv_nsec / 1000000)
 #endif
 #if LT_LOGGER_CALLER
 			,
@@ -91,12 +324,18 @@ void lt_log(const uint8_t level, const char *format, ...) {
 		line
 #endif
 	);
+	if (len < 0)
+		return;
 
-	va_list va_args;
-	va_start(va_args, format);
-	vsnprintf(message_buf, sizeof(message_buf), format, va_args);
-	va_end(va_args);
+	size_t size = sizeof(line_buf) - 2; // leave space for \r\n
+	if ((size_t)len < size) {
+		int ret = vsnprintf(line_buf + len, size - len, format, va_args);
+		if (ret > 0)
+			len += ret;
+	}
+	len				= min((size_t)len, size - 1);
+	line_buf[len++] = '\r';
+	line_buf[len++] = '\n';
 
-	printf("%s\r\n", message_buf);
-	fflush(stdout);
+	lt_log_enqueue(line_buf, len);
 }
@@ -13,43 +13,137 @@
 #define LT_LEVEL_ERROR	 4
 #define LT_LEVEL_FATAL	 5
 
+// Log modules, used with the LT_xM() macros
+#define LT_MODULES(X) X(MAIN) X(DB) X(LIVE) X(FRAME) X(RECORD) X(TRIP) X(POWER) X(ALERT)
+
+#define LT_MODULE_ENUM(name) LT_MODULE_##name,
+typedef enum lt_module_t {
+	LT_MODULES(LT_MODULE_ENUM) LT_MODULE_MAX,
+} lt_module_t;
+#undef LT_MODULE_ENUM
+
+extern uint8_t lt_log_levels[LT_MODULE_MAX]; //!< Runtime minimum level of each module
+
+void lt_log_set_level(lt_module_t module, uint8_t level);
+void lt_log_configure(const char *config);
+
+// only used to let the compiler check the format arguments
+static inline void lt_log_check(const char *format, ...) __attribute__((format(printf, 1, 2)));
+static inline void lt_log_check(const char *format, ...) {}
+
 #if LT_LOGGER_CALLER
+void lt_log(uint8_t level, const char *caller, unsigned short line, const char *format, ...)
+	__attribute__((format(printf, 4, 5)));
+void lt_vlog(uint8_t level, const char *caller, unsigned short line, const char *format, va_list va_args);
+#else
+void lt_log(uint8_t level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+void lt_vlog(uint8_t level, const char *format, va_list va_args);
+#endif
+
+#if LT_LOGGER_TRACE
+/**
+ * A single log call site, placed in the "lt_trace_sites" section by the linker.
+ * The site ID is its index in that section; argument types are parsed from the format when the trace is opened.
+ */
+typedef struct __attribute__((aligned(64))) lt_trace_site_t {
+	const char *caller;
+	const char *format;
+	unsigned short line;
+	uint8_t level;
+	uint8_t argc;
+	char types[LT_TRACE_MAX_ARGS];
+} lt_trace_site_t;
+
+#define LT_LOG(level, caller, line, format, ...)                                                                       \
+	do {                                                                                                               \
+		static lt_trace_site_t _lt_site __attribute__((section("lt_trace_sites"), used)) = {                          \
+			caller,                                                                                                    \
+			format,                                                                                                    \
+			line,                                                                                                      \
+			level,                                                                                                     \
+		};                                                                                                             \
+		if (0)                                                                                                         \
+			lt_log_check(format, ##__VA_ARGS__);                                                                       \
+		lt_trace(&_lt_site, ##__VA_ARGS__);                                                                            \
+	} while (0)
+#define LT_LOGM(level, module, caller, line, format, ...)                                                              \
+	do {                                                                                                               \
+		if (LT_DEBUG_##module && (level) >= lt_log_levels[LT_MODULE_##module]) {                                       \
+			LT_LOG(level, caller, line, #module ": " format, ##__VA_ARGS__);                                           \
+		}                                                                                                              \
+	} while (0)
+void lt_trace(lt_trace_site_t *site, ...);
+#elif LT_LOGGER_CALLER
 #define LT_LOG(level, caller, line, ...) lt_log(level, caller, line, __VA_ARGS__)
 #define LT_LOGM(level, module, caller, line, ...)                                                                      \
 	do {                                                                                                               \
-		if (LT_DEBUG_##module) {                                                                                       \
+		if (LT_DEBUG_##module && (level) >= lt_log_levels[LT_MODULE_##module]) {                                       \
 			lt_log(level, caller, line, #module ": " __VA_ARGS__);                                                     \
 		}                                                                                                              \
 	} while (0)
-void lt_log(uint8_t level, const char *caller, unsigned short line, const char *format, ...)
-	__attribute__((format(printf, 4, 5)));
 #else
 #define LT_LOG(level, caller, line, ...) lt_log(level, __VA_ARGS__)
 #define LT_LOGM(level, module, caller, line, ...)                                                                      \
 	do {                                                                                                               \
-		if (LT_DEBUG_##module) {                                                                                       \
+		if (LT_DEBUG_##module && (level) >= lt_log_levels[LT_MODULE_##module]) {                                       \
 			lt_log(level, #module ": " __VA_ARGS__);                                                                   \
 		}                                                                                                              \
 	} while (0)
-void lt_log(uint8_t level, const char *format, ...) __attribute__((format(printf, 2, 3)));
 #endif
 
+void lt_log_flush();
+
+// calls below LT_LOGGER_LEVEL are removed, their arguments are never evaluated
+#define LT_LOG_OFF(...)                                                                                                \
+	do {                                                                                                               \
+		if (0)                                                                                                         \
+			lt_log_check(__VA_ARGS__);                                                                                 \
+	} while (0)
+
+#if LT_LOGGER_LEVEL <= LT_LEVEL_TRACE
 #define LT_T(...)		   LT_LOG(LT_LEVEL_TRACE, __FUNCTION__, __LINE__, __VA_ARGS__)
 #define LT_V(...)		   LT_LOG(LT_LEVEL_TRACE, __FUNCTION__, __LINE__, __VA_ARGS__)
 #define LT_TM(module, ...) LT_LOGM(LT_LEVEL_TRACE, module, __FUNCTION__, __LINE__, __VA_ARGS__)
 #define LT_VM(module, ...) LT_LOGM(LT_LEVEL_TRACE, module, __FUNCTION__, __LINE__, __VA_ARGS__)
+#else
+#define LT_T(...)		   LT_LOG_OFF(__VA_ARGS__)
+#define LT_V(...)		   LT_LOG_OFF(__VA_ARGS__)
+#define LT_TM(module, ...) LT_LOG_OFF(__VA_ARGS__)
+#define LT_VM(module, ...) LT_LOG_OFF(__VA_ARGS__)
+#endif
 
+#if LT_LOGGER_LEVEL <= LT_LEVEL_DEBUG
 #define LT_D(...)		   LT_LOG(LT_LEVEL_DEBUG, __FUNCTION__, __LINE__, __VA_ARGS__)
 #define LT_DM(module, ...) LT_LOGM(LT_LEVEL_DEBUG, module, __FUNCTION__, __LINE__, __VA_ARGS__)
+#else
+#define LT_D(...)		   LT_LOG_OFF(__VA_ARGS__)
+#define LT_DM(module, ...) LT_LOG_OFF(__VA_ARGS__)
+#endif
 
+#if LT_LOGGER_LEVEL <= LT_LEVEL_INFO
 #define LT_I(...)		   LT_LOG(LT_LEVEL_INFO, __FUNCTION__, __LINE__, __VA_ARGS__)
 #define LT_IM(module, ...) LT_LOGM(LT_LEVEL_INFO, module, __FUNCTION__, __LINE__, __VA_ARGS__)
+#else
+#define LT_I(...)		   LT_LOG_OFF(__VA_ARGS__)
+#define LT_IM(module, ...) LT_LOG_OFF(__VA_ARGS__)
+#endif
 
+#if LT_LOGGER_LEVEL <= LT_LEVEL_WARN
 #define LT_W(...)		   LT_LOG(LT_LEVEL_WARN, __FUNCTION__, __LINE__, __VA_ARGS__)
 #define LT_WM(module, ...) LT_LOGM(LT_LEVEL_WARN, module, __FUNCTION__, __LINE__, __VA_ARGS__)
+#else
+#define LT_W(...)		   LT_LOG_OFF(__VA_ARGS__)
+#define LT_WM(module, ...) LT_LOG_OFF(__VA_ARGS__)
+#endif
 
+#if LT_LOGGER_LEVEL <= LT_LEVEL_ERROR
 #define LT_E(...)		   LT_LOG(LT_LEVEL_ERROR, __FUNCTION__, __LINE__, __VA_ARGS__)
 #define LT_EM(module, ...) LT_LOGM(LT_LEVEL_ERROR, module, __FUNCTION__, __LINE__, __VA_ARGS__)
+#else
+#define LT_E(...)		   LT_LOG_OFF(__VA_ARGS__)
+#define LT_EM(module, ...) LT_LOG_OFF(__VA_ARGS__)
+#endif
 
+// fatal errors are never removed
 #define LT_F(...)		   LT_LOG(LT_LEVEL_FATAL, __FUNCTION__, __LINE__, __VA_ARGS__)
 #define LT_FM(module, ...) LT_LOGM(LT_LEVEL_FATAL, module, __FUNCTION__, __LINE__, __VA_ARGS__)
@@ -0,0 +1,87 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#include "malloc_guard.h"
+
+#if MALLOC_GUARD
+
+#include <execinfo.h>
+
+// glibc allocator, called by the replacements below
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+
+static atomic_bool guard_armed		 = false;
+static atomic_bool guard_was_armed	 = false; //!< Whether the guard was ever armed, i.e. anything was checked
+static __thread bool guard_thread	 = false; //!< Whether the calling thread is on the ingest path
+static __thread bool guard_reporting = false;
+
+/**
+ * Mark the calling thread as part of the ingest path - it must not allocate once the guard is armed.
+ */
+void malloc_guard_thread() {
+	guard_thread = true;
+}
+
+/**
+ * Arm the guard after warm-up (lazy initialization, first statements), or disarm it before shutting down.
+ */
+void malloc_guard_arm(bool armed) {
+	atomic_store(&guard_armed, armed);
+	if (armed)
+		atomic_store(&guard_was_armed, true);
+	const char *msg = armed ? "malloc guard: armed\r\n" : "malloc guard: disarmed\r\n";
+	write(STDERR_FILENO, msg, strlen(msg));
+}
+
+bool malloc_guard_was_armed() {
+	return atomic_load(&guard_was_armed);
+}
+
+static void malloc_guard_check(const char *func, size_t size) {
+	if (!guard_thread || guard_reporting || !atomic_load_explicit(&guard_armed, memory_order_relaxed))
+		return;
+	// formatted without allocating - backtrace() may allocate when first called, which is not reported again
+	guard_reporting = true;
+	char msg[128];
+	int len = snprintf(msg, sizeof(msg), "malloc guard: %s(%zu) after warm-up\r\n", func, size);
+	write(STDERR_FILENO, msg, len);
+	void *frames[32];
+	int count = backtrace(frames, sizeof(frames) / sizeof(*frames));
+	backtrace_symbols_fd(frames, count, STDERR_FILENO);
+	abort();
+}
+
+void *malloc(size_t size) {
+	malloc_guard_check("malloc", size);
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+	malloc_guard_check("calloc", count * size);
+	return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+	malloc_guard_check("realloc", size);
+	return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+	malloc_guard_check("memalign", size);
+	return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+	malloc_guard_check("aligned_alloc", size);
+	return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+	malloc_guard_check("posix_memalign", size);
+	*ptr = __libc_memalign(alignment, size);
+	return *ptr == NULL ? ENOMEM : 0;
+}
+
+#endif
@@ -0,0 +1,19 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#pragma once
+
+#include "include.h"
+
+#if MALLOC_GUARD
+void malloc_guard_thread();
+void malloc_guard_arm(bool armed);
+bool malloc_guard_was_armed();
+#else
+static inline void malloc_guard_thread() {}
+
+static inline void malloc_guard_arm(bool armed) {}
+
+static inline bool malloc_guard_was_armed() {
+	return false;
+}
+#endif
@@ -0,0 +1,134 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#include "metrics.h"
+
+extern metric_t __start_lt_metrics[] __attribute__((weak));
+extern metric_t __stop_lt_metrics[] __attribute__((weak));
+
+static int metrics_fd = -1;
+
+static const char *metric_types[] = {"counter", "gauge", "histogram"};
+
+void metric_observe(metric_t *metric, unsigned long long value) {
+	unsigned int i = 0;
+	while (i < metric->bucket_count && value > metric->buckets[i])
+		i++;
+	atomic_fetch_add_explicit(&metric->counts[i], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&metric->sum, value, memory_order_relaxed);
+	atomic_fetch_add_explicit(&metric->value, 1, memory_order_relaxed);
+}
+
+unsigned long long metric_time_us() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void metrics_write_labels(FILE *file, const char *labels, const char *extra) {
+	if (labels == NULL && extra == NULL)
+		return;
+	fprintf(file, "{%s%s%s}", labels ?: "", labels && extra ? "," : "", extra ?: "");
+}
+
+void metrics_write(FILE *file) {
+	const char *last_name = NULL;
+	for (metric_t *metric = __start_lt_metrics; metric < __stop_lt_metrics; metric++) {
+		// metrics with the same name (i.e. arrays) share a single header
+		if (last_name == NULL || strcmp(last_name, metric->name) != 0) {
+			fprintf(file, "# HELP %s %s\n", metric->name, metric->help);
+			fprintf(file, "# TYPE %s %s\n", metric->name, metric_types[metric->type]);
+			last_name = metric->name;
+		}
+
+		if (metric->type != METRIC_HISTOGRAM) {
+			long long value = metric->read ? metric->read() : atomic_load(&metric->value);
+			fputs(metric->name, file);
+			metrics_write_labels(file, metric->labels, NULL);
+			fprintf(file, " %lld\n", value);
+			continue;
+		}
+
+		// histogram buckets are cumulative
+		char le[32];
+		unsigned long long total = 0;
+		for (unsigned int i = 0; i <= metric->bucket_count; i++) {
+			total += atomic_load_explicit(&metric->counts[i], memory_order_relaxed);
+			if (i < metric->bucket_count)
+				snprintf(le, sizeof(le), "le=\"%g\"", metric->buckets[i] / 1000000.0);
+			else
+				strcpy(le, "le=\"+Inf\"");
+			fprintf(file, "%s_bucket", metric->name);
+			metrics_write_labels(file, metric->labels, le);
+			fprintf(file, " %llu\n", total);
+		}
+		fprintf(file, "%s_sum", metric->name);
+		metrics_write_labels(file, metric->labels, NULL);
+		fprintf(file, " %.6f\n", atomic_load_explicit(&metric->sum, memory_order_relaxed) / 1000000.0);
+		fprintf(file, "%s_count", metric->name);
+		metrics_write_labels(file, metric->labels, NULL);
+		fprintf(file, " %llu\n", total);
+	}
+}
+
+static void *metrics_thread(void *arg) {
+	while (1) {
+		int fd = accept(metrics_fd, NULL, NULL);
+		if (fd == -1) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			break;
+		}
+		// send the whole text exposition and close the connection
+		char *buf	= NULL;
+		size_t size = 0;
+		FILE *file	= open_memstream(&buf, &size);
+		if (file != NULL) {
+			metrics_write(file);
+			fclose(file);
+			for (size_t pos = 0; pos < size;) {
+				ssize_t ret = send(fd, buf + pos, size - pos, MSG_NOSIGNAL);
+				if (ret <= 0)
+					break;
+				pos += ret;
+			}
+			free(buf);
+		}
+		close(fd);
+	}
+	return NULL;
+}
+
+bool metrics_open(const char *path) {
+	struct sockaddr_un addr = {
+		.sun_family = AF_UNIX,
+	};
+	strncpy2(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+	metrics_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (metrics_fd == -1)
+		SOCK_ERROR("socket(AF_UNIX)", goto error);
+	unlink(path);
+	if (bind(metrics_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+		SOCK_ERROR("bind()", goto error);
+	if (listen(metrics_fd, 4) != 0)
+		SOCK_ERROR("listen()", goto error);
+
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, metrics_thread, NULL) != 0)
+		LT_ERR(E, goto error, "Metrics: cannot create server thread");
+	pthread_detach(thread);
+
+	LT_IM(MAIN, "metrics served at %s", path);
+	return true;
+
+error:
+	metrics_close();
+	return false;
+}
+
+void metrics_close() {
+	if (metrics_fd == -1)
+		return;
+	close(metrics_fd);
+	metrics_fd = -1;
+}
@@ -0,0 +1,72 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#pragma once
+
+#include "include.h"
+
+typedef enum metric_type_t {
+	METRIC_COUNTER,
+	METRIC_GAUGE,
+	METRIC_HISTOGRAM,
+} metric_type_t;
+
+/**
+ * A single metric, placed in the "lt_metrics" section by the linker.
+ * All metrics in that section are exported, no registration is needed.
+ */
+typedef struct __attribute__((aligned(64))) metric_t {
+	metric_type_t type;
+	const char *name;
+	const char *labels; //!< Label set, i.e. id="0x0B6" (optional)
+	const char *help;
+	long long (*read)(); //!< Value getter, called on export (optional)
+	atomic_llong value;	 //!< Counter/gauge value, or number of histogram samples
+	atomic_ullong sum;	 //!< Sum of histogram samples (µs)
+	unsigned int bucket_count;
+	const unsigned long long *buckets; //!< Upper bounds of histogram buckets (µs)
+	atomic_ullong *counts;			   //!< Samples in each bucket, plus one for +Inf
+} metric_t;
+
+#define METRIC_SECTION __attribute__((section("lt_metrics"), used))
+
+#define METRIC_COUNTER(_name, _labels, _help)                                                                          \
+	{ .type = METRIC_COUNTER, .name = _name, .labels = _labels, .help = _help }
+#define METRIC_GAUGE(_name, _labels, _help)                                                                            \
+	{ .type = METRIC_GAUGE, .name = _name, .labels = _labels, .help = _help }
+#define METRIC_GAUGE_READ(_name, _labels, _help, _read)                                                                \
+	{ .type = METRIC_GAUGE, .name = _name, .labels = _labels, .help = _help, .read = _read }
+
+// define a histogram metric along with its bucket storage; bounds are in µs
+#define METRIC_DEFINE_HISTOGRAM(var, _name, _help, ...)                                                                \
+	static const unsigned long long var##_buckets[] = {__VA_ARGS__};                                                   \
+	static atomic_ullong var##_counts[sizeof(var##_buckets) / sizeof(*var##_buckets) + 1];                             \
+	static metric_t var METRIC_SECTION = {                                                                             \
+		.type		  = METRIC_HISTOGRAM,                                                                              \
+		.name		  = _name,                                                                                         \
+		.help		  = _help,                                                                                         \
+		.bucket_count = sizeof(var##_buckets) / sizeof(*var##_buckets),                                                \
+		.buckets	  = var##_buckets,                                                                                 \
+		.counts		  = var##_counts,                                                                                  \
+	}
+
+static inline void metric_add(metric_t *metric, long long value) {
+	atomic_fetch_add_explicit(&metric->value, value, memory_order_relaxed);
+}
+
+static inline void metric_inc(metric_t *metric) {
+	metric_add(metric, 1);
+}
+
+static inline void metric_dec(metric_t *metric) {
+	metric_add(metric, -1);
+}
+
+static inline void metric_set(metric_t *metric, long long value) {
+	atomic_store_explicit(&metric->value, value, memory_order_relaxed);
+}
+
+void metric_observe(metric_t *metric, unsigned long long value);
+unsigned long long metric_time_us();
+void metrics_write(FILE *file);
+bool metrics_open(const char *path);
+void metrics_close();
@@ -0,0 +1,333 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#include "logger.h"
+
+#if LT_LOGGER_TRACE
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <sys/mman.h>
+
+#define TRACE_MAGIC		  "LTTR"
+#define TRACE_VERSION	  1
+#define TRACE_ENTRY_MAGIC 0x4C54
+#define TRACE_STR_NULL	  0xFFFF
+#define TRACE_ALIGN(x)	  (((x) + 7) & ~(size_t)7)
+
+_Static_assert((LT_TRACE_SIZE & (LT_TRACE_SIZE - 1)) == 0, "Trace size must be a power of 2");
+_Static_assert(LT_TRACE_STR_MAX < TRACE_STR_NULL, "Trace string length too large");
+
+/**
+ * File header, followed by the site dictionary and the ring of entries.
+ * All integers are little-endian.
+ */
+typedef struct lt_trace_header_t {
+	char magic[4];
+	uint32_t version;
+	uint32_t site_count;
+	uint32_t dict_offset;
+	uint32_t dict_size;
+	uint32_t ring_offset;
+	uint32_t ring_size;
+	uint32_t reserved;
+	_Atomic uint64_t write_pos; //!< Total number of bytes written to the ring
+	uint8_t padding[24];
+} lt_trace_header_t;
+
+_Static_assert(sizeof(lt_trace_header_t) == 64, "Trace header size mismatch");
+
+/**
+ * Dictionary entry of a single site, followed by caller, format and argument types (without NUL).
+ */
+typedef struct __attribute__((packed)) lt_trace_dict_t {
+	uint16_t line;
+	uint8_t level;
+	uint8_t argc;
+	uint16_t caller_len;
+	uint16_t format_len;
+} lt_trace_dict_t;
+
+/**
+ * Ring entry, followed by the raw arguments and padded to 8 bytes.
+ */
+typedef struct __attribute__((packed)) lt_trace_entry_t {
+	uint16_t magic;
+	uint16_t site;
+	uint32_t size;
+	uint64_t time; //!< Wall-clock time in microseconds
+} lt_trace_entry_t;
+
+extern lt_trace_site_t __start_lt_trace_sites[] __attribute__((weak));
+extern lt_trace_site_t __stop_lt_trace_sites[] __attribute__((weak));
+
+static pthread_once_t trace_once	 = PTHREAD_ONCE_INIT;
+static lt_trace_header_t *trace_file = NULL;
+static uint8_t *trace_ring			 = NULL;
+
+static __thread uint8_t
+	trace_buf[TRACE_ALIGN(sizeof(lt_trace_entry_t) + LT_TRACE_MAX_ARGS * (sizeof(uint64_t) + 2 + LT_TRACE_STR_MAX))]
+	__attribute__((aligned(8)));
+
+static char lt_trace_int_type(size_t size) {
+	return size > sizeof(int32_t) ? 'l' : 'i';
+}
+
+/**
+ * Find the argument types of a printf-style format.
+ *
+ * i - int32, l - int64, d - double, D - long double (stored as double),
+ * p - pointer (stored as uint64), s - string, P - int32 precision of the following string.
+ */
+static void lt_trace_parse(lt_trace_site_t *site) {
+	const char *fmt = site->format;
+	uint8_t argc	= 0;
+	while ((fmt = strchr(fmt, '%')) != NULL && argc < LT_TRACE_MAX_ARGS) {
+		fmt++;
+		if (*fmt == '%') {
+			fmt++;
+			continue;
+		}
+		fmt += strspn(fmt, "-+ #0'");
+		// width and precision
+		bool precision = false;
+		while ((*fmt >= '0' && *fmt <= '9') || *fmt == '.' || *fmt == '*') {
+			if (*fmt == '.')
+				precision = true;
+			if (*fmt == '*')
+				site->types[argc++] = precision ? 'P' : 'i';
+			fmt++;
+		}
+		if (argc >= LT_TRACE_MAX_ARGS)
+			break;
+		// length modifier
+		size_t size = sizeof(int);
+		bool ldbl	= false;
+		for (bool done = false; !done; fmt++) {
+			switch (*fmt) {
+				case 'h':
+					break;
+				case 'l':
+					size = fmt[-1] == 'l' ? sizeof(long long) : sizeof(long);
+					break;
+				case 'q':
+					size = sizeof(long long);
+					break;
+				case 'j':
+					size = sizeof(intmax_t);
+					break;
+				case 'z':
+					size = sizeof(size_t);
+					break;
+				case 't':
+					size = sizeof(ptrdiff_t);
+					break;
+				case 'L':
+					ldbl = true;
+					break;
+				default:
+					done = true;
+					fmt--;
+					break;
+			}
+		}
+		// conversion
+		switch (*fmt) {
+			case 'd':
+			case 'i':
+			case 'u':
+			case 'o':
+			case 'x':
+			case 'X':
+			case 'c':
+				site->types[argc++] = lt_trace_int_type(size);
+				break;
+			case 'f':
+			case 'F':
+			case 'e':
+			case 'E':
+			case 'g':
+			case 'G':
+			case 'a':
+			case 'A':
+				site->types[argc++] = ldbl ? 'D' : 'd';
+				break;
+			case 's':
+				site->types[argc++] = 's';
+				break;
+			case 'p':
+			case 'n':
+				site->types[argc++] = 'p';
+				break;
+			case '\0':
+				fmt--;
+				break;
+		}
+		fmt++;
+	}
+	site->argc = argc;
+}
+
+static void lt_trace_open() {
+	size_t site_count = __stop_lt_trace_sites - __start_lt_trace_sites;
+	size_t dict_size  = 0;
+	for (size_t i = 0; i < site_count; i++) {
+		lt_trace_site_t *site = &__start_lt_trace_sites[i];
+		lt_trace_parse(site);
+		dict_size += sizeof(lt_trace_dict_t) + strlen(site->caller) + strlen(site->format) + site->argc;
+	}
+	size_t ring_offset = TRACE_ALIGN(sizeof(lt_trace_header_t) + dict_size);
+	size_t file_size   = ring_offset + LT_TRACE_SIZE;
+
+	// keep the trace of the previous run
+	rename(LT_TRACE_FILE, LT_TRACE_FILE ".old");
+
+	int fd = open(LT_TRACE_FILE, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd == -1)
+		return;
+	if (ftruncate(fd, (off_t)file_size) != 0) {
+		close(fd);
+		return;
+	}
+	uint8_t *map = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return;
+
+	lt_trace_header_t *header = (void *)map;
+	header->version			  = TRACE_VERSION;
+	header->site_count		  = site_count;
+	header->dict_offset		  = sizeof(lt_trace_header_t);
+	header->dict_size		  = dict_size;
+	header->ring_offset		  = ring_offset;
+	header->ring_size		  = LT_TRACE_SIZE;
+	atomic_init(&header->write_pos, 0);
+
+	uint8_t *dict = map + header->dict_offset;
+	for (size_t i = 0; i < site_count; i++) {
+		lt_trace_site_t *site = &__start_lt_trace_sites[i];
+		lt_trace_dict_t entry = {
+			.line		= site->line,
+			.level		= site->level,
+			.argc		= site->argc,
+			.caller_len = strlen(site->caller),
+			.format_len = strlen(site->format),
+		};
+		memcpy(dict, &entry, sizeof(entry));
+		dict += sizeof(entry);
+		memcpy(dict, site->caller, entry.caller_len);
+		dict += entry.caller_len;
+		memcpy(dict, site->format, entry.format_len);
+		dict += entry.format_len;
+		memcpy(dict, site->types, entry.argc);
+		dict += entry.argc;
+	}
+	// mark the file as valid once the dictionary is complete
+	memcpy(header->magic, TRACE_MAGIC, sizeof(header->magic));
+
+	trace_file = header;
+	trace_ring = map + ring_offset;
+}
+
+static void lt_trace_vlog(lt_trace_site_t *site, va_list va_args) {
+#if LT_LOGGER_CALLER
+	lt_vlog(site->level, site->caller, site->line, site->format, va_args);
+#else
+	lt_vlog(site->level, site->format, va_args);
+#endif
+}
+
+void lt_trace(lt_trace_site_t *site, ...) {
+	pthread_once(&trace_once, lt_trace_open);
+	va_list va_args;
+
+	if (trace_file == NULL) {
+		// trace file unavailable - log as text instead
+		va_start(va_args, site);
+		lt_trace_vlog(site, va_args);
+		va_end(va_args);
+		return;
+	}
+
+	// store the raw arguments, without any formatting
+	uint8_t *out = trace_buf + sizeof(lt_trace_entry_t);
+	int str_max	 = LT_TRACE_STR_MAX;
+	va_start(va_args, site);
+	for (uint8_t i = 0; i < site->argc; i++) {
+		switch (site->types[i]) {
+			case 'i':
+			case 'P': {
+				int32_t value = va_arg(va_args, int);
+				memcpy(out, &value, sizeof(value));
+				out += sizeof(value);
+				if (site->types[i] == 'P' && value >= 0)
+					str_max = min(value, LT_TRACE_STR_MAX);
+				break;
+			}
+			case 'l': {
+				int64_t value = va_arg(va_args, int64_t);
+				memcpy(out, &value, sizeof(value));
+				out += sizeof(value);
+				break;
+			}
+			case 'd': {
+				double value = va_arg(va_args, double);
+				memcpy(out, &value, sizeof(value));
+				out += sizeof(value);
+				break;
+			}
+			case 'D': {
+				double value = (double)va_arg(va_args, long double);
+				memcpy(out, &value, sizeof(value));
+				out += sizeof(value);
+				break;
+			}
+			case 'p': {
+				uint64_t value = (uintptr_t)va_arg(va_args, void *);
+				memcpy(out, &value, sizeof(value));
+				out += sizeof(value);
+				break;
+			}
+			case 's': {
+				const char *value = va_arg(va_args, const char *);
+				uint16_t len	  = value ? strnlen(value, str_max) : TRACE_STR_NULL;
+				memcpy(out, &len, sizeof(len));
+				out += sizeof(len);
+				if (value) {
+					memcpy(out, value, len);
+					out += len;
+				}
+				str_max = LT_TRACE_STR_MAX;
+				break;
+			}
+		}
+	}
+	va_end(va_args);
+
+	struct timespec tv;
+	clock_gettime(CLOCK_REALTIME, &tv);
+	size_t size			   = TRACE_ALIGN(out - trace_buf);
+	lt_trace_entry_t entry = {
+		.magic = TRACE_ENTRY_MAGIC,
+		.site  = site - __start_lt_trace_sites,
+		.size  = size,
+		.time  = (uint64_t)tv.tv_sec * 1000000 + tv.tv_nsec / 1000,
+	};
+	memcpy(trace_buf, &entry, sizeof(entry));
+	memset(out, 0, size - (out - trace_buf));
+
+	// reserve space in the ring and copy the entry, wrapping around its end
+	uint64_t pos  = atomic_fetch_add_explicit(&trace_file->write_pos, size, memory_order_relaxed);
+	size_t offset = pos & (LT_TRACE_SIZE - 1);
+	size_t chunk  = min(size, LT_TRACE_SIZE - offset);
+	memcpy(trace_ring + offset, trace_buf, chunk);
+	memcpy(trace_ring, trace_buf + chunk, size - chunk);
+
+	if (site->level >= LT_LEVEL_WARN) {
+		// warnings and errors are printed as well
+		va_start(va_args, site);
+		lt_trace_vlog(site, va_args);
+		va_end(va_args);
+	}
+}
+
+#endif
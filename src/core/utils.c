@@ -29,12 +29,6 @@ void hexdump(const void *buf, size_t len) {
 	fflush(stdout);
 }
 
-unsigned long long millis() {
-	struct timeval tv;
-	gettimeofday(&tv, NULL);
-	return (unsigned long long)tv.tv_sec * 1000 + tv.tv_usec / 1000;
-}
-
 char *strncpy2(char *dest, const char *src, size_t count) {
 	strncpy(dest, src, count);
 	dest[count] = '\0';
@@ -10,6 +10,8 @@
 #define CONCAT_(prefix, suffix) prefix##suffix
 #define CONCAT(prefix, suffix)	CONCAT_(prefix, suffix)
 #define UNIQ(name)				CONCAT(name, __LINE__)
+#define STRINGIFY_(value)		#value
+#define STRINGIFY(value)		STRINGIFY_(value)
 
 #define FREE_NULL(var)                                                                                                 \
 	do {                                                                                                               \
@@ -38,5 +40,4 @@
 #include "include.h"
 
 void hexdump(const void *buf, size_t len);
-unsigned long long millis();
 char *strncpy2(char *dest, const char *src, size_t count);
@@ -16,3 +16,17 @@ void measurement_append(measurement_t *meas, double value) {
 			meas->max = value;
 	}
 }
+
+void measurement_merge(measurement_t *meas, measurement_t *other) {
+	if (!other->is_init)
+		return;
+	if (!meas->is_init) {
+		*meas = *other;
+		return;
+	}
+	unsigned int count = meas->count + other->count;
+	meas->avg		   = (meas->avg * meas->count + other->avg * other->count) / (double)count;
+	meas->count		   = count;
+	meas->min		   = min(meas->min, other->min);
+	meas->max		   = max(meas->max, other->max);
+}
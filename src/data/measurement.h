@@ -13,3 +13,4 @@ typedef struct measurement_t {
 } measurement_t;
 
 void measurement_append(measurement_t *meas, double value);
+void measurement_merge(measurement_t *meas, measurement_t *other);
@@ -2,6 +2,14 @@
 
 #include "record.h"
 
+// aggregate a decoded value and check the alert rules of its signal
+#define record_measure(record, field, value, now)                                                                      \
+	do {                                                                                                               \
+		double _value = (value);                                                                                       \
+		measurement_append(&(record)->field, _value);                                                                  \
+		alert_check(ALERT_SIGNAL_##field, _value, now);                                                                \
+	} while (0)
+
 void record_reset(record_t *record) {
 	bool is_init		   = record->is_init;
 	unsigned int dist_last = record->dist_last;
@@ -17,7 +25,7 @@ void record_reset(record_t *record) {
 }
 
 void record_append(record_t *record, frame_t *frame) {
-	unsigned long long now = millis();
+	unsigned long long now = clock_mono_ms();
 	if (record->start.time == 0)
 		record->start.time = now;
 	record->end.time = now;
@@ -27,8 +35,8 @@ void record_append(record_t *record, frame_t *frame) {
 			break;
 
 		case FRAME_BSI_FAST:
-			measurement_append(&record->engine_speed, frame->bsi_fast.engine_speed * 0.125);
-			measurement_append(&record->vehicle_speed, frame->bsi_fast.vehicle_speed * 0.01);
+			record_measure(record, engine_speed, frame->bsi_fast.engine_speed * 0.125, now);
+			record_measure(record, vehicle_speed, frame->bsi_fast.vehicle_speed * 0.01, now);
 			unsigned int dist_raw = frame->bsi_fast.dist * 10;
 			unsigned int fuel_raw = frame->bsi_fast.fuel * 80;
 			if (!record->is_init) {
@@ -36,10 +44,11 @@ void record_append(record_t *record, frame_t *frame) {
 			} else {
 				unsigned int dist = dist_raw;
 				unsigned int fuel = fuel_raw;
+				// 16-bit distance and 8-bit fuel counters wrap around
 				if (dist < record->dist_last)
-					dist += 65535 * 10;
+					dist += 65536 * 10;
 				if (fuel < record->fuel_last)
-					fuel += 255 * 80;
+					fuel += 256 * 80;
 				record->dist += dist - record->dist_last;
 				record->fuel += fuel - record->fuel_last;
 			}
@@ -48,24 +57,24 @@ void record_append(record_t *record, frame_t *frame) {
 			break;
 
 		case FRAME_BSI_SLOW:
-			measurement_append(&record->coolant_temp, frame->bsi_slow.coolant_temp);
-			measurement_append(&record->outside_temp, frame->bsi_slow.outside_temp * 0.5);
+			record_measure(record, coolant_temp, frame->bsi_slow.coolant_temp, now);
+			record_measure(record, outside_temp, frame->bsi_slow.outside_temp * 0.5, now);
 			if (record->start.mileage == 0.0)
 				record->start.mileage = frame->bsi_slow.total_mileage * 0.1;
 			record->end.mileage = frame->bsi_slow.total_mileage * 0.1;
 			break;
 
 		case FRAME_TEMP_LEVEL:
-			measurement_append(&record->oil_temp, frame->temp_level.oil_temp);
-			measurement_append(&record->oil_level, frame->temp_level.oil_level);
-			measurement_append(&record->fuel_level, frame->temp_level.fuel_level);
+			record_measure(record, oil_temp, frame->temp_level.oil_temp, now);
+			record_measure(record, oil_level, frame->temp_level.oil_level, now);
+			record_measure(record, fuel_level, frame->temp_level.fuel_level, now);
 			break;
 
 		case FRAME_TRIP_GENERAL:
 			if (!frame->trip_general.invalid_cons)
-				measurement_append(&record->fuel_cons, frame->trip_general.fuel_cons * 0.1);
+				record_measure(record, fuel_cons, frame->trip_general.fuel_cons * 0.1, now);
 			if (!frame->trip_general.invalid_range)
-				measurement_append(&record->fuel_range, frame->trip_general.fuel_range);
+				record_measure(record, fuel_range, frame->trip_general.fuel_range, now);
 			break;
 
 		case FRAME_TRIP_DATA_1:
@@ -91,7 +100,8 @@ void record_append(record_t *record, frame_t *frame) {
 void record_print(record_t *record) {
 	if (record->start.time == record->end.time)
 		return;
-	LT_I(
+	LT_IM(
+		RECORD,
 		"Time: %lld sec/%u sec - "
 		"Distance: %.3f km/%u km - "
 		"Fuel: %.3f l (%u%%) - "
@@ -9,7 +9,7 @@
 typedef struct frame_t frame_t;
 
 typedef struct record_stat_t {
-	unsigned long long time; //!< Time of the measurements
+	unsigned long long time; //!< Time of the measurements (clock_mono_ms(), wall-clock if read from the database)
 
 	double mileage; //!< Total mileage (km)
 
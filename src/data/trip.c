@@ -31,37 +31,75 @@ void trip_append(trip_t *trip, record_t *record) {
 	measurement_append(&trip->outside_temp, record->outside_temp.avg);
 	measurement_append(&trip->oil_temp, record->oil_temp.avg);
 	// min/max only
-	measurement_append(&trip->oil_level, record->oil_temp.avg);
+	measurement_append(&trip->oil_level, record->oil_level.avg);
 	measurement_append(&trip->fuel_level, record->fuel_level.avg);
 	measurement_append(&trip->fuel_range, record->fuel_range.avg);
 	measurement_append(&trip->fuel_cons, record->fuel_cons.min);
 	measurement_append(&trip->fuel_cons, record->fuel_cons.max);
 }
 
+/**
+ * Check whether 'record' starts a new trip, i.e. it ends more than 'gap' ms after the end of 'trip'.
+ * Records ending before the trip (i.e. saved before the clock was re-anchored) never start a new one.
+ */
+bool trip_split(trip_t *trip, record_t *record, unsigned long long gap) {
+	return trip->end_time != 0 && (long long)record->end.time - (long long)trip->end_time > (long long)gap;
+}
+
+/**
+ * Append all records of 'other' (a trip that follows 'trip') to 'trip'.
+ */
+void trip_merge(trip_t *trip, trip_t *other) {
+	if (trip->end_time == 0) {
+		*trip = *other;
+		return;
+	}
+	trip->time += other->time;
+	trip->dist += other->dist;
+	trip->fuel += other->fuel;
+	trip->start_time	= min(trip->start_time, other->start_time);
+	trip->end_time		= max(trip->end_time, other->end_time);
+	trip->start_mileage = min(trip->start_mileage, other->start_mileage);
+	trip->end_mileage	= max(trip->end_mileage, other->end_mileage);
+	measurement_merge(&trip->engine_speed, &other->engine_speed);
+	measurement_merge(&trip->vehicle_speed, &other->vehicle_speed);
+	measurement_merge(&trip->coolant_temp, &other->coolant_temp);
+	measurement_merge(&trip->outside_temp, &other->outside_temp);
+	measurement_merge(&trip->oil_temp, &other->oil_temp);
+	measurement_merge(&trip->oil_level, &other->oil_level);
+	measurement_merge(&trip->fuel_level, &other->fuel_level);
+	measurement_merge(&trip->fuel_range, &other->fuel_range);
+	measurement_merge(&trip->fuel_cons, &other->fuel_cons);
+}
+
 void trip_print(trip_t *trip) {
-	LT_I(
-		"Trip: %llu-%llu, time: %u ms, dist: %u cm, fuel: %u mm³",
+	LT_IM(
+		TRIP,
+		"%llu-%llu, time: %u ms, dist: %u cm, fuel: %u mm³",
 		trip->start_time,
 		trip->end_time,
 		trip->time,
 		trip->dist,
 		trip->fuel
 	);
-	LT_I("Trip: %.1f km - %.1f km", trip->start_mileage, trip->end_mileage);
-	LT_I(
-		"Trip: engine speed (max): %u RPM, vehicle speed (max): %.2f km/h",
+	LT_IM(TRIP, "%.1f km - %.1f km", trip->start_mileage, trip->end_mileage);
+	LT_IM(
+		TRIP,
+		"engine speed (max): %u RPM, vehicle speed (max): %.2f km/h",
 		(int)trip->engine_speed.max,
 		trip->vehicle_speed.max
 	);
-	LT_I("Trip: fuel level (min): %u%%, fuel level (max): %u%%", (int)trip->fuel_level.min, (int)trip->fuel_level.max);
-	LT_I(
-		"Trip: fuel cons. (min): %.1f l/100 km, fuel cons. (max): %.1f l/100 km",
+	LT_IM(TRIP, "fuel level (min): %u%%, fuel level (max): %u%%", (int)trip->fuel_level.min, (int)trip->fuel_level.max);
+	LT_IM(
+		TRIP,
+		"fuel cons. (min): %.1f l/100 km, fuel cons. (max): %.1f l/100 km",
 		trip->fuel_cons.min,
 		trip->fuel_cons.max
 	);
 	if (trip->dist && trip->time)
-		LT_I(
-			"Trip: avg speed: %.1f km/h, avg cons.: %.1f l/100 km",
+		LT_IM(
+			TRIP,
+			"avg speed: %.1f km/h, avg cons.: %.1f l/100 km",
 			trip->dist / (double)trip->time * 36.0,
 			trip->fuel * 10.0 / trip->dist
 		);
@@ -29,4 +29,6 @@ typedef struct trip_t {
 
 void trip_reset(trip_t *trip);
 void trip_append(trip_t *trip, record_t *record);
+bool trip_split(trip_t *trip, record_t *record, unsigned long long gap);
+void trip_merge(trip_t *trip, trip_t *other);
 void trip_print(trip_t *trip);
@@ -4,10 +4,215 @@
 
 static sqlite3 *db				= NULL;
 static pthread_mutex_t db_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char *db_filename		= NULL;
 
-static void db_save_record_thread(record_t *record);
-static void db_save_trip_thread(trip_t *trip);
-static void db_process_trips_thread(void *arg);
+static trip_t trip_current			= {0}; //!< Trip built from records not assigned to any trip yet
+static long long trip_current_rowid = 0;   //!< Last record rowid appended to trip_current
+static long long db_boot_rowid		= 0;   //!< Last record rowid saved before db_connect()
+static long long db_boot_alert_id	= 0;   //!< Last alert saved before db_connect()
+
+static sqlite3_stmt *db_record_insert = NULL; //!< Cached statement of db_save_record_job()
+static sqlite3_stmt *db_record_select = NULL; //!< Cached statement of db_process_trips_job()
+
+typedef enum db_job_type_t {
+	DB_JOB_SAVE_RECORD,
+	DB_JOB_SAVE_ALERT,
+	DB_JOB_PROCESS_TRIPS,
+	DB_JOB_REANCHOR,
+	DB_JOB_STANDBY,
+	DB_JOB_PREWARM,
+	DB_JOB_STOP,
+} db_job_type_t;
+
+/**
+ * A job of the database thread, with its arguments copied into a preallocated slot.
+ */
+typedef struct db_job_t {
+	db_job_type_t type;
+
+	union {
+		record_t record; //!< DB_JOB_SAVE_RECORD
+		alert_t alert;	 //!< DB_JOB_SAVE_ALERT
+		long long delta; //!< DB_JOB_REANCHOR
+	};
+} db_job_t;
+
+// jobs run one by one, in the order they were queued
+static db_job_t db_jobs[DATABASE_JOB_SLOTS];
+static size_t db_job_head			= 0; //!< Next slot to fill (producers)
+static size_t db_job_tail			= 0; //!< Slot of the job that runs next (database thread)
+static pthread_mutex_t db_job_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t db_job_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t db_job_done	= PTHREAD_COND_INITIALIZER;
+static pthread_t db_worker;
+static bool db_worker_running = false;
+
+// completed trips found by one db_process_trips_job() pass, saved after reading the records
+static trip_t db_trip_batch[DATABASE_TRIP_BATCH];
+
+static void *db_worker_thread(void *arg);
+static db_job_t *db_job_reserve(db_job_type_t type);
+static void db_job_submit();
+static bool db_job_next_processes();
+static void db_save_record_job(record_t *record);
+static void db_save_alert_job(alert_t *alert);
+static bool db_save_trip(trip_t *trip);
+static void db_process_trips_job();
+static void db_reanchor_job(long long delta);
+static bool db_reanchor_records(long long reanchor_id, long long delta, long long first_rowid, long long last_rowid);
+static bool db_reanchor_resume();
+static void db_standby_job();
+static void db_prewarm_job();
+static bool db_prepare_cached(sqlite3_stmt **stmt, const char *sql);
+static void db_release(sqlite3_stmt *stmt);
+static void db_finalize_cached();
+static bool db_migrate_begin(bool *migrate);
+static bool db_migrate_end();
+static void db_bind_trip(sqlite3_stmt *stmt, int index, trip_t *trip);
+static long long db_size_main();
+static long long db_size_wal();
+
+static metric_t metric_db_pending METRIC_SECTION =
+	METRIC_GAUGE("triplogger_db_pending", NULL, "Database jobs waiting to be processed");
+static metric_t metric_records_saved METRIC_SECTION =
+	METRIC_COUNTER("triplogger_records_saved_total", NULL, "Records saved to the database");
+static metric_t metric_trips_saved METRIC_SECTION =
+	METRIC_COUNTER("triplogger_trips_saved_total", NULL, "Trips saved to the database");
+static metric_t metric_db_size[] METRIC_SECTION = {
+	METRIC_GAUGE_READ("triplogger_db_size_bytes", "file=\"db\"", "Size of the database files", db_size_main),
+	METRIC_GAUGE_READ("triplogger_db_size_bytes", "file=\"wal\"", "Size of the database files", db_size_wal),
+	METRIC_GAUGE_READ(
+		"triplogger_db_size_bytes",
+		"file=\"partition\"",
+		"Size of the database files",
+		db_partition_size
+	),
+};
+METRIC_DEFINE_HISTOGRAM(
+	metric_db_write,
+	"triplogger_db_write_seconds",
+	"Duration of record and trip writes",
+	1000,
+	2500,
+	5000,
+	10000,
+	25000,
+	50000,
+	100000,
+	250000,
+	500000,
+	1000000
+);
+METRIC_DEFINE_HISTOGRAM(
+	metric_trip_process,
+	"triplogger_trip_process_seconds",
+	"Duration of trip processing",
+	1000,
+	5000,
+	10000,
+	50000,
+	100000,
+	500000,
+	1000000,
+	5000000
+);
+
+// calendar periods of trip_stats, as date() modifiers (applied in local time)
+#define TRIP_STATS_PERIODS                                                                                             \
+	"(VALUES "                                                                                                         \
+	"('day', 'start of day', '+0 days', '+0 days'), "                                                                  \
+	"('week', 'weekday 0', '-6 days', 'start of day'), "                                                               \
+	"('month', 'start of month', '+0 days', '+0 days'), "                                                              \
+	"('year', 'start of year', '+0 days', '+0 days')"                                                                  \
+	") AS p"
+// start of the period containing 'time' (ms)
+#define TRIP_STATS_PERIOD_START(time)                                                                                  \
+	"strftime('%s', " time " / 1000, 'unixepoch', 'localtime', p.column2, p.column3, p.column4, 'utc') * 1000"
+// statements used for every record, prepared once (see db_prepare_cached())
+static const char *db_sql_record_insert = (
+	// record
+	"INSERT INTO record ("
+	"start_time, end_time, start_mileage, end_mileage, "
+	"dist, fuel, engine_speed, engine_speed_max, "
+	"vehicle_speed_min, vehicle_speed_max, "
+	"coolant_temp, outside_temp, oil_temp, oil_level, "
+	"fuel_level, fuel_range, fuel_cons_min, fuel_cons_max"
+	") VALUES ("
+	"?, ?, ?, ?, "
+	"?, ?, ?, ?, "
+	"?, ?, "
+	"?, ?, ?, ?, "
+	"?, ?, ?, ?"
+	");"
+);
+static const char *db_sql_record_select = (
+	// record
+	"SELECT rowid, " DB_RECORD_SELECT " "
+	"FROM record "
+	"WHERE trip_id IS NULL AND rowid > ? "
+	// records are inserted in time order - reading by rowid keeps trip_current_rowid past consumed rows only
+	"ORDER BY rowid;"
+);
+static const char *db_sql_trip_insert = (
+	// trip
+	"INSERT INTO trip ("
+	"time, dist, fuel, "
+	"start_time, end_time, start_mileage, end_mileage, "
+	"engine_speed_max, vehicle_speed_max, "
+	"coolant_temp_avg, coolant_temp_min, coolant_temp_max, "
+	"outside_temp_avg, outside_temp_min, outside_temp_max, "
+	"oil_temp_avg, oil_temp_min, oil_temp_max, "
+	"oil_level_min, oil_level_max, fuel_level_min, fuel_level_max, "
+	"fuel_range_min, fuel_range_max, fuel_cons_min, fuel_cons_max"
+	") VALUES ("
+	"?, ?, ?, "
+	"?, ?, ?, ?, "
+	"?, ?, "
+	"?, ?, ?, "
+	"?, ?, ?, "
+	"?, ?, ?, "
+	"?, ?, ?, ?, "
+	"?, ?, ?, ?"
+	");"
+);
+static const char *db_sql_trip_current_insert = (
+	// trip_current
+	"INSERT OR REPLACE INTO trip_current ("
+	"trip_id, time, dist, fuel, "
+	"start_time, end_time, start_mileage, end_mileage, "
+	"engine_speed_max, vehicle_speed_max, "
+	"coolant_temp_avg, coolant_temp_min, coolant_temp_max, "
+	"outside_temp_avg, outside_temp_min, outside_temp_max, "
+	"oil_temp_avg, oil_temp_min, oil_temp_max, "
+	"oil_level_min, oil_level_max, fuel_level_min, fuel_level_max, "
+	"fuel_range_min, fuel_range_max, fuel_cons_min, fuel_cons_max"
+	") VALUES ("
+	"0, ?, ?, ?, "
+	"?, ?, ?, ?, "
+	"?, ?, "
+	"?, ?, ?, "
+	"?, ?, ?, "
+	"?, ?, ?, "
+	"?, ?, ?, ?, "
+	"?, ?, ?, ?"
+	");"
+);
+
+// scales of all scaled columns, for migrating older databases
+#define DB_SCALE_ENTRY(column, scale) {#column, scale},
+static const db_scale_t db_scales[] = {DB_SCALES(DB_SCALE_ENTRY)};
+
+// tables whose columns were stored as REAL before version 1
+static const char *db_scaled_tables[] = {"record", "trip", "trip_current"};
+
+// build the totals of all trips (trip_stats must be empty)
+#define TRIP_STATS_BUILD                                                                                               \
+	"INSERT INTO trip_stats "                                                                                          \
+	"SELECT p.column1, " TRIP_STATS_PERIOD_START("start_time") ", "                                                    \
+	"COUNT(*), SUM(time), SUM(dist), SUM(fuel) "                                                                       \
+	"FROM trip, " TRIP_STATS_PERIODS " "                                                                               \
+	"WHERE NOT EXISTS (SELECT 1 FROM trip_stats) "                                                                     \
+	"GROUP BY 1, 2;"
 
 sqlite3 *db_connect(const char *filename) {
 	if (db != NULL)
@@ -16,81 +221,209 @@ sqlite3 *db_connect(const char *filename) {
 		SQLITE3_ERROR("sqlite3_open()", return NULL);
 
 	pthread_mutex_init(&db_mutex, NULL);
+	db_filename = strdup(filename);
+	trip_reset(&trip_current);
+	trip_current_rowid = 0;
+
+	LT_IM(DB, "opened %s", filename);
+
+	// let the web server read the database without blocking the logger
+	if (sqlite3_exec(db, "PRAGMA journal_mode = WAL;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(PRAGMA journal_mode)", return NULL);
+
+	// tables of an older version are renamed, then copied to the tables created below
+	bool migrate = false;
+	if (!db_migrate_begin(&migrate))
+		return NULL;
 
-	LT_I("Database: opened %s", filename);
+	// records of older versions are copied to "main", before being split into partitions
+	if (migrate && !db_partition_create_table(db, "main"))
+		return NULL;
 
 	const char *sql = (
 		// record
-		"CREATE TABLE IF NOT EXISTS record ("
-		"start_time INTEGER NOT NULL, "
-		"end_time INTEGER NOT NULL, "
-		"start_mileage REAL NOT NULL, "
-		"end_mileage REAL NOT NULL, "
+		"CREATE TABLE IF NOT EXISTS trip ("
+		"trip_id INTEGER NOT NULL PRIMARY KEY, "
+		"time INTEGER NOT NULL, "
 		"dist INTEGER NOT NULL, "
 		"fuel INTEGER NOT NULL, "
-		"engine_speed REAL NOT NULL, "
-		"engine_speed_max REAL NOT NULL, "
-		"vehicle_speed_min REAL NOT NULL, "
-		"vehicle_speed_max REAL NOT NULL, "
-		"coolant_temp REAL NOT NULL, "
-		"outside_temp REAL NOT NULL, "
-		"oil_temp REAL NOT NULL, "
-		"oil_level REAL NOT NULL, "
-		"fuel_level REAL NOT NULL, "
-		"fuel_range REAL NOT NULL, "
-		"fuel_cons_min REAL NOT NULL, "
-		"fuel_cons_max REAL NOT NULL, "
-		"trip_id INTEGER DEFAULT NULL, "
-		"PRIMARY KEY(start_time, end_time)"
+		"start_time INTEGER NOT NULL, "
+		"end_time INTEGER NOT NULL, "
+		"start_mileage INTEGER NOT NULL, "
+		"end_mileage INTEGER NOT NULL, "
+		"engine_speed_max INTEGER NOT NULL, "
+		"vehicle_speed_max INTEGER NOT NULL, "
+		"coolant_temp_avg INTEGER NOT NULL, "
+		"coolant_temp_min INTEGER NOT NULL, "
+		"coolant_temp_max INTEGER NOT NULL, "
+		"outside_temp_avg INTEGER NOT NULL, "
+		"outside_temp_min INTEGER NOT NULL, "
+		"outside_temp_max INTEGER NOT NULL, "
+		"oil_temp_avg INTEGER NOT NULL, "
+		"oil_temp_min INTEGER NOT NULL, "
+		"oil_temp_max INTEGER NOT NULL, "
+		"oil_level_min INTEGER NOT NULL, "
+		"oil_level_max INTEGER NOT NULL, "
+		"fuel_level_min INTEGER NOT NULL, "
+		"fuel_level_max INTEGER NOT NULL, "
+		"fuel_range_min INTEGER NOT NULL, "
+		"fuel_range_max INTEGER NOT NULL, "
+		"fuel_cons_min INTEGER NOT NULL, "
+		"fuel_cons_max INTEGER NOT NULL"
 		");"
+		// trips are identified by their start time when saved again (see db_save_trip())
+		"CREATE INDEX IF NOT EXISTS trip_start_time ON trip (start_time);"
 	);
 	if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
 		SQLITE3_ERROR("sqlite3_exec(CREATE TABLE)", return NULL);
 
 	sql = (
-		// record
-		"CREATE TABLE IF NOT EXISTS trip ("
+		// current (unsaved) trip - a single row with trip_id = 0
+		"CREATE TABLE IF NOT EXISTS trip_current ("
 		"trip_id INTEGER NOT NULL PRIMARY KEY, "
 		"time INTEGER NOT NULL, "
 		"dist INTEGER NOT NULL, "
 		"fuel INTEGER NOT NULL, "
 		"start_time INTEGER NOT NULL, "
 		"end_time INTEGER NOT NULL, "
-		"start_mileage REAL NOT NULL, "
-		"end_mileage REAL NOT NULL, "
-		"engine_speed_max REAL NOT NULL, "
-		"vehicle_speed_max REAL NOT NULL, "
-		"coolant_temp_avg REAL NOT NULL, "
-		"coolant_temp_min REAL NOT NULL, "
-		"coolant_temp_max REAL NOT NULL, "
-		"outside_temp_avg REAL NOT NULL, "
-		"outside_temp_min REAL NOT NULL, "
-		"outside_temp_max REAL NOT NULL, "
-		"oil_temp_avg REAL NOT NULL, "
-		"oil_temp_min REAL NOT NULL, "
-		"oil_temp_max REAL NOT NULL, "
-		"oil_level_min REAL NOT NULL, "
-		"oil_level_max REAL NOT NULL, "
-		"fuel_level_min REAL NOT NULL, "
-		"fuel_level_max REAL NOT NULL, "
-		"fuel_range_min REAL NOT NULL, "
-		"fuel_range_max REAL NOT NULL, "
-		"fuel_cons_min REAL NOT NULL, "
-		"fuel_cons_max REAL NOT NULL"
+		"start_mileage INTEGER NOT NULL, "
+		"end_mileage INTEGER NOT NULL, "
+		"engine_speed_max INTEGER NOT NULL, "
+		"vehicle_speed_max INTEGER NOT NULL, "
+		"coolant_temp_avg INTEGER NOT NULL, "
+		"coolant_temp_min INTEGER NOT NULL, "
+		"coolant_temp_max INTEGER NOT NULL, "
+		"outside_temp_avg INTEGER NOT NULL, "
+		"outside_temp_min INTEGER NOT NULL, "
+		"outside_temp_max INTEGER NOT NULL, "
+		"oil_temp_avg INTEGER NOT NULL, "
+		"oil_temp_min INTEGER NOT NULL, "
+		"oil_temp_max INTEGER NOT NULL, "
+		"oil_level_min INTEGER NOT NULL, "
+		"oil_level_max INTEGER NOT NULL, "
+		"fuel_level_min INTEGER NOT NULL, "
+		"fuel_level_max INTEGER NOT NULL, "
+		"fuel_range_min INTEGER NOT NULL, "
+		"fuel_range_max INTEGER NOT NULL, "
+		"fuel_cons_min INTEGER NOT NULL, "
+		"fuel_cons_max INTEGER NOT NULL"
+		");"
+	);
+	if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(CREATE TABLE)", return NULL);
+
+	sql = (
+		// alerts raised by the rules (see alert.c) - end_time is NULL while raised
+		"CREATE TABLE IF NOT EXISTS alert ("
+		"alert_id INTEGER NOT NULL PRIMARY KEY, "
+		"rule TEXT NOT NULL, "
+		"signal TEXT NOT NULL, "
+		"start_time INTEGER NOT NULL, "
+		"end_time INTEGER, "
+		"value INTEGER NOT NULL, "
+		"threshold INTEGER NOT NULL"
+		");"
+		"CREATE INDEX IF NOT EXISTS alert_start_time ON alert (start_time);"
+	);
+	if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(CREATE TABLE)", return NULL);
+
+	sql = (
+		// trip totals per calendar period
+		"CREATE TABLE IF NOT EXISTS trip_stats ("
+		"period TEXT NOT NULL, "
+		"period_start INTEGER NOT NULL, "
+		"trips INTEGER NOT NULL, "
+		"time INTEGER NOT NULL, "
+		"dist INTEGER NOT NULL, "
+		"fuel INTEGER NOT NULL, "
+		"PRIMARY KEY(period, period_start)"
+		") WITHOUT ROWID;"
+		// build the totals of trips saved before trip_stats existed
+		TRIP_STATS_BUILD
+	);
+	if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(CREATE TABLE)", return NULL);
+
+	sql = (
+		// re-anchoring of records that is not finished yet (see db_reanchor_job())
+		"CREATE TABLE IF NOT EXISTS reanchor ("
+		"reanchor_id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, "
+		"delta INTEGER NOT NULL, "
+		"first_rowid INTEGER NOT NULL, "
+		"last_rowid INTEGER NOT NULL"
 		");"
 	);
 	if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
 		SQLITE3_ERROR("sqlite3_exec(CREATE TABLE)", return NULL);
 
+	if (migrate && !db_migrate_end())
+		return NULL;
+	// records are stored in per-period files, attached as DB_PARTITION_SCHEMA
+	if (!db_partition_open(db, filename))
+		return NULL;
+
+	// finish writes to the partition that were interrupted by a power cut, after the main database was written
+	if (!db_reanchor_resume())
+		return NULL;
+	sql = (
+		// records of trips saved right before a power cut, left unassigned (see db_save_trip())
+		"UPDATE record SET trip_id = ("
+		"SELECT trip_id FROM trip "
+		"WHERE start_time <= record.start_time AND end_time > record.start_time "
+		"AND start_time < record.end_time AND end_time >= record.end_time"
+		") "
+		"WHERE trip_id IS NULL AND start_time < (SELECT IFNULL(MAX(end_time), 0) FROM trip);"
+	);
+	if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(UPDATE record)", return NULL);
+
+	if (sqlite3_exec(db, "PRAGMA user_version = " STRINGIFY(DB_VERSION) ";", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(PRAGMA user_version)", return NULL);
+
+	// records saved from now on may need to be re-anchored (see db_reanchor())
+	sqlite3_stmt *stmt = NULL;
+	if (sqlite3_prepare_v2(db, "SELECT IFNULL(MAX(rowid), 0) FROM record;", -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", return NULL);
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		db_boot_rowid = sqlite3_column_int64(stmt, 0);
+	sqlite3_finalize(stmt);
+
+	sql = (
+		// alerts left raised by an unclean shutdown end with the last record
+		"UPDATE alert SET end_time = MAX(start_time, (SELECT IFNULL(MAX(end_time), 0) FROM record)) "
+		"WHERE end_time IS NULL;"
+	);
+	if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(UPDATE alert)", return NULL);
+	if (sqlite3_prepare_v2(db, "SELECT IFNULL(MAX(alert_id), 0) FROM alert;", -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", return NULL);
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		db_boot_alert_id = sqlite3_column_int64(stmt, 0);
+	sqlite3_finalize(stmt);
+
+	// all jobs run on a single thread, started once
+	db_job_head = db_job_tail = 0;
+	if (pthread_create(&db_worker, NULL, db_worker_thread, NULL) != 0)
+		LT_ERR(E, return NULL, "Database: cannot create database thread");
+	db_worker_running = true;
+
 	return db;
 }
 
 void db_close() {
+	if (db_worker_running && db_job_reserve(DB_JOB_STOP) != NULL) {
+		db_job_submit();
+		pthread_join(db_worker, NULL);
+	}
+	db_worker_running = false;
 	pthread_mutex_lock(&db_mutex);
+	db_finalize_cached();
 	pthread_mutex_unlock(&db_mutex);
 	pthread_mutex_destroy(&db_mutex);
 	sqlite3_close(db);
 	db = NULL;
+	FREE_NULL(db_filename);
 }
 
 void db_save_record(record_t *record) {
@@ -99,164 +432,394 @@ void db_save_record(record_t *record) {
 		db_process_trips();
 		return;
 	}
-	record_t *record_copy;
-	MALLOC(record_copy, sizeof(*record_copy), goto error);
-	memcpy(record_copy, record, sizeof(*record));
-
-	pthread_t thread;
-	if (pthread_create(&thread, NULL, (void *(*)(void *))db_save_record_thread, record_copy) != 0)
-		LT_ERR(E, goto error, "Database: cannot create record save thread");
+	db_job_t *job = db_job_reserve(DB_JOB_SAVE_RECORD);
+	if (job == NULL)
+		return;
+	job->record = *record;
+	db_job_submit();
+}
 
-	return;
+void db_save_alert(alert_t *alert) {
+	db_job_t *job = db_job_reserve(DB_JOB_SAVE_ALERT);
+	if (job == NULL)
+		return;
+	job->alert = *alert;
+	db_job_submit();
+}
 
-error:
-	free(record_copy);
+void db_process_trips() {
+	if (db_job_reserve(DB_JOB_PROCESS_TRIPS) != NULL)
+		db_job_submit();
 }
 
-void db_save_trip(trip_t *trip) {
-	if (trip->start_time == trip->end_time || trip->dist == 0)
-		// nothing to save
+void db_reanchor(long long delta) {
+	db_job_t *job = db_job_reserve(DB_JOB_REANCHOR);
+	if (job == NULL)
 		return;
-	trip_t *trip_copy;
-	MALLOC(trip_copy, sizeof(*trip_copy), goto error);
-	memcpy(trip_copy, trip, sizeof(*trip));
-
-	pthread_t thread;
-	if (pthread_create(&thread, NULL, (void *(*)(void *))db_save_trip_thread, trip_copy) != 0)
-		LT_ERR(E, goto error, "Database: cannot create record save thread");
+	job->delta = delta;
+	db_job_submit();
+}
 
-	return;
+void db_standby() {
+	if (db_job_reserve(DB_JOB_STANDBY) != NULL)
+		db_job_submit();
+}
 
-error:
-	free(trip_copy);
+void db_prewarm() {
+	if (db_job_reserve(DB_JOB_PREWARM) != NULL)
+		db_job_submit();
 }
 
-void db_process_trips() {
-	pthread_t thread;
-	if (pthread_create(&thread, NULL, (void *(*)(void *))db_process_trips_thread, NULL) != 0)
-		LT_ERR(E, , "Database: cannot create record save thread");
+/**
+ * Continue building the trip from a checkpoint, instead of reading all unassigned records.
+ */
+bool db_restore_trip(trip_t *trip, long long rowid) {
+	bool ret		   = false;
+	sqlite3_stmt *stmt = NULL;
+	pthread_mutex_lock(&db_mutex);
+	// reject checkpoints that don't match this database (i.e. written for another file)
+	if (rowid > db_boot_rowid)
+		LT_ERR(W, goto cleanup, "Database: checkpointed rowid %lld beyond last record", rowid);
+	// reject trips that were saved after the checkpoint was written
+	if (sqlite3_prepare_v2(db, "SELECT 1 FROM trip WHERE start_time = ?;", -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+	sqlite3_bind_int64(stmt, 1, (long long)trip->start_time);
+	if (trip->end_time != 0 && sqlite3_step(stmt) == SQLITE_ROW)
+		LT_ERR(W, goto cleanup, "Database: checkpointed trip already saved");
+	trip_current	   = *trip;
+	trip_current_rowid = rowid;
+	ret				   = true;
+
+cleanup:
+	sqlite3_finalize(stmt);
+	pthread_mutex_unlock(&db_mutex);
+	return ret;
 }
 
-static void db_save_record_thread(record_t *record) {
+bool db_has_record(unsigned long long start_time) {
+	bool ret = false;
 	pthread_mutex_lock(&db_mutex);
+	sqlite3_stmt *stmt = NULL;
+	if (sqlite3_prepare_v2(db, "SELECT 1 FROM record WHERE start_time = ?;", -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+	sqlite3_bind_int64(stmt, 1, (long long)start_time);
+	ret = sqlite3_step(stmt) == SQLITE_ROW;
 
-	const char *sql = (
-		// record
-		"INSERT INTO record ("
-		"start_time, end_time, start_mileage, end_mileage, "
-		"dist, fuel, engine_speed, engine_speed_max, "
-		"vehicle_speed_min, vehicle_speed_max, "
-		"coolant_temp, outside_temp, oil_temp, oil_level, "
-		"fuel_level, fuel_range, fuel_cons_min, fuel_cons_max"
-		") VALUES ("
-		"?, ?, ?, ?, "
-		"?, ?, ?, ?, "
-		"?, ?, "
-		"?, ?, ?, ?, "
-		"?, ?, ?, ?"
-		");"
-	);
+cleanup:
+	sqlite3_finalize(stmt);
+	pthread_mutex_unlock(&db_mutex);
+	return ret;
+}
 
+/**
+ * Replace all trips, the current trip and the period totals at once - used when rebuilding trips
+ * from records. Trips must be in time order, as they get trip IDs 1..count.
+ */
+bool db_replace_trips(trip_t *trips, size_t count, trip_t *current) {
+	pthread_mutex_lock(&db_mutex);
+	bool commit		   = false;
 	sqlite3_stmt *stmt = NULL;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+	if (sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(BEGIN)", goto cleanup);
+	if (sqlite3_exec(db, "DELETE FROM trip; DELETE FROM trip_current;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(DELETE)", goto cleanup);
+
+	if (sqlite3_prepare_v2(db, db_sql_trip_insert, -1, &stmt, NULL) != SQLITE_OK)
 		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+	for (size_t i = 0; i < count; i++) {
+		db_bind_trip(stmt, 1, &trips[i]);
+		if (sqlite3_step(stmt) != SQLITE_DONE)
+			SQLITE3_ERROR("sqlite3_step()", goto cleanup);
+		sqlite3_reset(stmt);
+	}
+	sqlite3_finalize(stmt);
+	stmt = NULL;
+
+	if (current != NULL && current->end_time != 0) {
+		if (sqlite3_prepare_v2(db, db_sql_trip_current_insert, -1, &stmt, NULL) != SQLITE_OK)
+			SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+		db_bind_trip(stmt, 1, current);
+		if (sqlite3_step(stmt) != SQLITE_DONE)
+			SQLITE3_ERROR("sqlite3_step()", goto cleanup);
+	}
+
+	if (sqlite3_exec(db, "DELETE FROM trip_stats;" TRIP_STATS_BUILD, NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(trip_stats)", goto cleanup);
+	commit = true;
+
+cleanup:
+	sqlite3_finalize(stmt);
+	if (sqlite3_exec(db, commit ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(COMMIT)", commit = false);
+	pthread_mutex_unlock(&db_mutex);
+	return commit;
+}
+
+/**
+ * Read DB_RECORD_SELECT columns of 'stmt', starting at 'index'.
+ */
+void db_column_record(sqlite3_stmt *stmt, int index, record_t *record) {
+	record->start.time		  = sqlite3_column_int64(stmt, index);
+	record->end.time		  = sqlite3_column_int64(stmt, index + 1);
+	record->start.mileage	  = db_column_scaled(stmt, index + 2, start_mileage);
+	record->end.mileage		  = db_column_scaled(stmt, index + 3, end_mileage);
+	record->dist			  = sqlite3_column_int(stmt, index + 4);
+	record->fuel			  = sqlite3_column_int(stmt, index + 5);
+	record->engine_speed.avg  = db_column_scaled(stmt, index + 6, engine_speed);
+	record->engine_speed.max  = db_column_scaled(stmt, index + 7, engine_speed_max);
+	record->vehicle_speed.min = db_column_scaled(stmt, index + 8, vehicle_speed_min);
+	record->vehicle_speed.max = db_column_scaled(stmt, index + 9, vehicle_speed_max);
+	record->coolant_temp.avg  = db_column_scaled(stmt, index + 10, coolant_temp);
+	record->outside_temp.avg  = db_column_scaled(stmt, index + 11, outside_temp);
+	record->oil_temp.avg	  = db_column_scaled(stmt, index + 12, oil_temp);
+	record->oil_level.avg	  = db_column_scaled(stmt, index + 13, oil_level);
+	record->fuel_level.avg	  = db_column_scaled(stmt, index + 14, fuel_level);
+	record->fuel_range.avg	  = db_column_scaled(stmt, index + 15, fuel_range);
+	record->fuel_cons.min	  = db_column_scaled(stmt, index + 16, fuel_cons_min);
+	record->fuel_cons.max	  = db_column_scaled(stmt, index + 17, fuel_cons_max);
+}
+
+void db_wait() {
+	// wait until all queued jobs are finished
+	while (atomic_load(&metric_db_pending.value) != 0) {
+		usleep(100);
+	}
+}
+
+static void *db_worker_thread(void *arg) {
+	malloc_guard_thread();
+	while (1) {
+		pthread_mutex_lock(&db_job_mutex);
+		while (db_job_head == db_job_tail)
+			pthread_cond_wait(&db_job_queued, &db_job_mutex);
+		// the slot is only freed after the job is done, so it's not overwritten while running
+		db_job_t *job = &db_jobs[db_job_tail % DATABASE_JOB_SLOTS];
+		pthread_mutex_unlock(&db_job_mutex);
+
+		db_job_type_t type = job->type;
+		switch (type) {
+			case DB_JOB_SAVE_RECORD:
+				db_save_record_job(&job->record);
+				// process trips *after* saving the record - unless the next job does it anyway
+				if (!db_job_next_processes())
+					db_process_trips_job();
+				break;
+			case DB_JOB_SAVE_ALERT:
+				db_save_alert_job(&job->alert);
+				break;
+			case DB_JOB_PROCESS_TRIPS:
+				if (!db_job_next_processes())
+					db_process_trips_job();
+				break;
+			case DB_JOB_REANCHOR:
+				db_reanchor_job(job->delta);
+				break;
+			case DB_JOB_STANDBY:
+				db_standby_job();
+				break;
+			case DB_JOB_PREWARM:
+				db_prewarm_job();
+				break;
+			case DB_JOB_STOP:
+				break;
+		}
 
-	sqlite3_bind_int64(stmt, 1, (long long)record->start.time);
-	sqlite3_bind_int64(stmt, 2, (long long)record->end.time);
-	sqlite3_bind_double(stmt, 3, record->start.mileage);
-	sqlite3_bind_double(stmt, 4, record->end.mileage);
+		pthread_mutex_lock(&db_job_mutex);
+		db_job_tail++;
+		pthread_cond_broadcast(&db_job_done);
+		pthread_mutex_unlock(&db_job_mutex);
+		metric_dec(&metric_db_pending);
+		if (type == DB_JOB_STOP)
+			break;
+	}
+	return NULL;
+}
+
+/**
+ * Reserve a slot of the job queue, waiting for one if the database falls behind. Fill the returned job
+ * and queue it with db_job_submit().
+ *
+ * @return the reserved job (with the queue locked), or NULL if the database is not connected
+ */
+static db_job_t *db_job_reserve(db_job_type_t type) {
+	if (!db_worker_running)
+		LT_ERR(E, return NULL, "Database: not connected, job %d dropped", type);
+	metric_inc(&metric_db_pending);
+	pthread_mutex_lock(&db_job_mutex);
+	while (db_job_head - db_job_tail == DATABASE_JOB_SLOTS)
+		pthread_cond_wait(&db_job_done, &db_job_mutex);
+	db_job_t *job = &db_jobs[db_job_head % DATABASE_JOB_SLOTS];
+	job->type	  = type;
+	return job;
+}
+
+static void db_job_submit() {
+	db_job_head++;
+	pthread_cond_signal(&db_job_queued);
+	pthread_mutex_unlock(&db_job_mutex);
+}
+
+static bool db_job_next_processes() {
+	// records saved one after another are processed at once, after the last one
+	pthread_mutex_lock(&db_job_mutex);
+	bool ret = false;
+	if (db_job_head - db_job_tail > 1) {
+		db_job_type_t next = db_jobs[(db_job_tail + 1) % DATABASE_JOB_SLOTS].type;
+		ret				   = next == DB_JOB_SAVE_RECORD || next == DB_JOB_PROCESS_TRIPS;
+	}
+	pthread_mutex_unlock(&db_job_mutex);
+	return ret;
+}
+
+static void db_save_record_job(record_t *record) {
+	pthread_mutex_lock(&db_mutex);
+	unsigned long long start = metric_time_us();
+
+	sqlite3_stmt *stmt = NULL;
+	if (!db_prepare_cached(&db_record_insert, db_sql_record_insert))
+		goto cleanup;
+	stmt = db_record_insert;
+
+	// convert under the mutex, so that db_reanchor() sees all records saved with the previous anchor
+	unsigned long long start_time = clock_wall_ms(record->start.time);
+	unsigned long long end_time	  = clock_wall_ms(record->end.time);
+	sqlite3_bind_int64(stmt, 1, (long long)start_time);
+	sqlite3_bind_int64(stmt, 2, (long long)end_time);
+	db_bind_scaled(stmt, 3, record->start.mileage, start_mileage);
+	db_bind_scaled(stmt, 4, record->end.mileage, end_mileage);
 	sqlite3_bind_int(stmt, 5, (int)record->dist);
 	sqlite3_bind_int(stmt, 6, (int)record->fuel);
-	sqlite3_bind_double(stmt, 7, round(record->engine_speed.avg * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 8, round(record->engine_speed.max * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 9, round(record->vehicle_speed.min * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 10, round(record->vehicle_speed.max * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 11, round(record->coolant_temp.avg * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 12, round(record->outside_temp.avg * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 13, round(record->oil_temp.avg * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 14, round(record->oil_level.avg * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 15, round(record->fuel_level.avg * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 16, round(record->fuel_range.avg * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 17, round(record->fuel_cons.min * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 18, round(record->fuel_cons.max * 1000.0) / 1000.0);
+	db_bind_scaled(stmt, 7, record->engine_speed.avg, engine_speed);
+	db_bind_scaled(stmt, 8, record->engine_speed.max, engine_speed_max);
+	db_bind_scaled(stmt, 9, record->vehicle_speed.min, vehicle_speed_min);
+	db_bind_scaled(stmt, 10, record->vehicle_speed.max, vehicle_speed_max);
+	db_bind_scaled(stmt, 11, record->coolant_temp.avg, coolant_temp);
+	db_bind_scaled(stmt, 12, record->outside_temp.avg, outside_temp);
+	db_bind_scaled(stmt, 13, record->oil_temp.avg, oil_temp);
+	db_bind_scaled(stmt, 14, record->oil_level.avg, oil_level);
+	db_bind_scaled(stmt, 15, record->fuel_level.avg, fuel_level);
+	db_bind_scaled(stmt, 16, record->fuel_range.avg, fuel_range);
+	db_bind_scaled(stmt, 17, record->fuel_cons.min, fuel_cons_min);
+	db_bind_scaled(stmt, 18, record->fuel_cons.max, fuel_cons_max);
 
 	if (sqlite3_step(stmt) != SQLITE_DONE)
 		SQLITE3_ERROR("sqlite3_step()", goto cleanup);
-	else
-		LT_I("Database: record saved, end time = %llu", record->end.time);
+	LT_IM(DB, "record saved, end time = %llu", end_time);
+	metric_inc(&metric_records_saved);
+	metric_observe(&metric_db_write, metric_time_us() - start);
 
 cleanup:
-	sqlite3_finalize(stmt);
-	free(record);
+	db_release(stmt);
 	pthread_mutex_unlock(&db_mutex);
-
-	// call the trip processing function *after* saving the record
-	db_process_trips();
 }
 
-static void db_save_trip_thread(trip_t *trip) {
+static void db_save_alert_job(alert_t *alert) {
 	pthread_mutex_lock(&db_mutex);
-
-	const char *sql = (
-		// trip
-		"INSERT INTO trip ("
-		"time, dist, fuel, "
-		"start_time, end_time, start_mileage, end_mileage, "
-		"engine_speed_max, vehicle_speed_max, "
-		"coolant_temp_avg, coolant_temp_min, coolant_temp_max, "
-		"outside_temp_avg, outside_temp_min, outside_temp_max, "
-		"oil_temp_avg, oil_temp_min, oil_temp_max, "
-		"oil_level_min, oil_level_max, fuel_level_min, fuel_level_max, "
-		"fuel_range_min, fuel_range_max, fuel_cons_min, fuel_cons_max"
-		") VALUES ("
-		"?, ?, ?, "
-		"?, ?, ?, ?, "
-		"?, ?, "
-		"?, ?, ?, "
-		"?, ?, ?, "
-		"?, ?, ?, "
-		"?, ?, ?, ?, "
-		"?, ?, ?, ?"
-		");"
+	sqlite3_stmt *stmt = NULL;
+	// alerts are rare - not worth caching the statements
+	const char *sql = alert->active ? (
+		"INSERT INTO alert (rule, signal, start_time, value, threshold) VALUES (?1, ?2, ?3, ?4, ?5);"
+	) : (
+		// at most one alert of a rule is raised at a time
+		"UPDATE alert SET end_time = ?3 WHERE rule = ?1 AND end_time IS NULL;"
 	);
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+	sqlite3_bind_text(stmt, 1, alert->rule, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, alert_signal_name(alert->signal), -1, SQLITE_STATIC);
+	// converted under the mutex, like records (see db_save_record_job())
+	sqlite3_bind_int64(stmt, 3, (long long)clock_wall_ms(alert->time));
+	if (alert->active) {
+		db_bind_scaled(stmt, 4, alert->value, value);
+		db_bind_scaled(stmt, 5, alert->limit, threshold);
+	}
+	if (sqlite3_step(stmt) != SQLITE_DONE)
+		SQLITE3_ERROR("sqlite3_step()", goto cleanup);
+	LT_DM(DB, "alert %s %s", alert->rule, alert->active ? "saved" : "ended");
+
+cleanup:
+	sqlite3_finalize(stmt);
+	pthread_mutex_unlock(&db_mutex);
+}
+
+/**
+ * Save a completed trip, update period totals and assign its records. Called with db_mutex locked.
+ *
+ * WAL transactions are not atomic across attached databases, so the trip is saved in the main database first, which
+ * is authoritative, and its records are assigned afterwards. A trip saved already (i.e. right before a power cut,
+ * leaving its records unassigned) is found by its start time, and is not saved or counted again.
+ */
+static bool db_save_trip(trip_t *trip) {
+	if (trip->start_time == trip->end_time || trip->dist == 0)
+		// nothing to save
+		return false;
+	unsigned long long start = metric_time_us();
+
+	bool commit		   = false;
+	bool saved		   = false;
+	long long trip_id  = 0;
 	sqlite3_stmt *stmt = NULL;
+	if (sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(BEGIN)", goto cleanup);
+
+	const char *sql = "SELECT trip_id FROM trip WHERE start_time = ?;";
 	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
 		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+	sqlite3_bind_int64(stmt, 1, (long long)trip->start_time);
+	if (sqlite3_step(stmt) == SQLITE_ROW) {
+		trip_id = sqlite3_column_int64(stmt, 0);
+		LT_WM(DB, "trip already saved, trip ID = %lld", trip_id);
+		commit = true;
+		goto cleanup;
+	}
 
-	sqlite3_bind_int(stmt, 1, (int)trip->time);
-	sqlite3_bind_int(stmt, 2, (int)trip->dist);
-	sqlite3_bind_int(stmt, 3, (int)trip->fuel);
-	sqlite3_bind_int64(stmt, 4, (long long)trip->start_time);
-	sqlite3_bind_int64(stmt, 5, (long long)trip->end_time);
-	sqlite3_bind_double(stmt, 6, trip->start_mileage);
-	sqlite3_bind_double(stmt, 7, trip->end_mileage);
-	sqlite3_bind_double(stmt, 8, round(trip->engine_speed.max * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 9, round(trip->vehicle_speed.max * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 10, round(trip->coolant_temp.avg * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 11, round(trip->coolant_temp.min * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 12, round(trip->coolant_temp.max * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 13, round(trip->outside_temp.avg * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 14, round(trip->outside_temp.min * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 15, round(trip->outside_temp.max * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 16, round(trip->oil_temp.avg * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 17, round(trip->oil_temp.min * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 18, round(trip->oil_temp.max * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 19, round(trip->oil_level.min * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 20, round(trip->oil_level.max * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 21, round(trip->fuel_level.min * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 22, round(trip->fuel_level.max * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 23, round(trip->fuel_range.min * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 24, round(trip->fuel_range.max * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 25, round(trip->fuel_cons.min * 1000.0) / 1000.0);
-	sqlite3_bind_double(stmt, 26, round(trip->fuel_cons.max * 1000.0) / 1000.0);
+	sqlite3_finalize(stmt);
+	sql = db_sql_trip_insert;
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+
+	db_bind_trip(stmt, 1, trip);
 
 	if (sqlite3_step(stmt) != SQLITE_DONE)
 		SQLITE3_ERROR("sqlite3_step()", goto cleanup);
 
-	long long trip_id = sqlite3_last_insert_rowid(db);
-	LT_I("Database: trip saved, trip ID = %lld", trip_id);
+	trip_id = sqlite3_last_insert_rowid(db);
+	LT_IM(DB, "trip saved, trip ID = %lld", trip_id);
 
 	sqlite3_finalize(stmt);
+	sql = (
+		// trip_stats
+		"INSERT INTO trip_stats "
+		"SELECT p.column1, " TRIP_STATS_PERIOD_START("?1") ", 1, ?2, ?3, ?4 "
+		"FROM " TRIP_STATS_PERIODS " "
+		"WHERE true "
+		"ON CONFLICT (period, period_start) DO UPDATE SET "
+		"trips = trips + excluded.trips, "
+		"time = time + excluded.time, "
+		"dist = dist + excluded.dist, "
+		"fuel = fuel + excluded.fuel;"
+	);
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+
+	sqlite3_bind_int64(stmt, 1, (long long)trip->start_time);
+	sqlite3_bind_int64(stmt, 2, (long long)trip->time);
+	sqlite3_bind_int64(stmt, 3, (long long)trip->dist);
+	sqlite3_bind_int64(stmt, 4, (long long)trip->fuel);
+
+	if (sqlite3_step(stmt) != SQLITE_DONE)
+		SQLITE3_ERROR("sqlite3_step()", goto cleanup);
+	commit = true;
+	saved  = true;
+
+cleanup:
+	sqlite3_finalize(stmt);
+	stmt = NULL;
+	if (sqlite3_exec(db, commit ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(COMMIT)", commit = false);
+	if (!commit)
+		return false;
+
 	sql = (
 		// record
 		"UPDATE record "
@@ -265,7 +828,7 @@ static void db_save_trip_thread(trip_t *trip) {
 		"AND end_time > ? AND end_time <= ?;"
 	);
 	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
-		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+		SQLITE3_ERROR("sqlite3_prepare_v2()", return true);
 
 	sqlite3_bind_int64(stmt, 1, trip_id);
 	sqlite3_bind_int64(stmt, 2, (long long)trip->start_time);
@@ -273,88 +836,502 @@ static void db_save_trip_thread(trip_t *trip) {
 	sqlite3_bind_int64(stmt, 4, (long long)trip->start_time);
 	sqlite3_bind_int64(stmt, 5, (long long)trip->end_time);
 
+	// the trip is saved either way - its records are assigned again by db_connect()
+	if (sqlite3_step(stmt) != SQLITE_DONE)
+		SQLITE3_ERROR("sqlite3_step()", );
+	sqlite3_finalize(stmt);
+	if (saved) {
+		metric_inc(&metric_trips_saved);
+		metric_observe(&metric_db_write, metric_time_us() - start);
+	}
+	return true;
+}
+
+static void db_process_trips_job() {
+	pthread_mutex_lock(&db_mutex);
+	unsigned long long start = metric_time_us();
+
+	const char *sql	   = NULL;
+	sqlite3_stmt *stmt = NULL;
+	trip_t *trip	   = &trip_current;
+	record_t record	   = {0};
+	record_reset(&record);
+
+	// completed trips are saved in batches - the records are read again after each one
+	size_t count = 0, saved = 0;
+	bool more	 = true;
+	while (more) {
+		if (!db_prepare_cached(&db_record_select, db_sql_record_select))
+			goto cleanup;
+		stmt = db_record_select;
+
+		// only read records that were not appended to the current trip yet
+		sqlite3_bind_int64(stmt, 1, trip_current_rowid);
+
+		count = 0;
+		more  = false;
+		while (1) {
+			int ret = sqlite3_step(stmt);
+			if (ret == SQLITE_BUSY) {
+				sleep(1);
+				continue;
+			}
+			if (ret == SQLITE_DONE)
+				break;
+			if (ret != SQLITE_ROW)
+				SQLITE3_ERROR("sqlite3_step()", goto cleanup);
+
+			long long rowid = sqlite3_column_int64(stmt, 0);
+			db_column_record(stmt, 1, &record);
+
+			if (trip_split(trip, &record, TRIP_GAP_TIME)) {
+				// start a new trip if there was no record for 5 min
+				trip_print(trip);
+				db_trip_batch[count++] = *trip;
+				trip_reset(trip);
+			}
+
+			// add this record to the trip
+			trip_append(trip, &record);
+			trip_current_rowid = rowid;
+			if (count == DATABASE_TRIP_BATCH) {
+				more = true;
+				break;
+			}
+		}
+		db_release(stmt);
+		stmt = NULL;
+
+		// signed - the clock may be behind a restored trip (i.e. before it's synchronized), which isn't a gap
+		long long idle = (long long)clock_now_ms() - (long long)trip->end_time;
+		if (!more && trip->end_time != 0 && idle > TRIP_GAP_TIME) {
+			// save the last records if they are older than 5 min
+			trip_print(trip);
+			db_trip_batch[count++] = *trip;
+			trip_reset(trip);
+		}
+		for (size_t i = 0; i < count; i++) {
+			saved += db_save_trip(&db_trip_batch[i]);
+		}
+	}
+
+	if (trip->end_time != 0) {
+		sql = db_sql_trip_current_insert;
+	} else {
+		// no trip in progress
+		sql = "DELETE FROM trip_current;";
+	}
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+	if (trip->end_time != 0)
+		db_bind_trip(stmt, 1, trip);
 	if (sqlite3_step(stmt) != SQLITE_DONE)
 		SQLITE3_ERROR("sqlite3_step()", goto cleanup);
+	metric_observe(&metric_trip_process, metric_time_us() - start);
+
+	// start a new partition if the period changed, between trips
+	if (saved != 0 && trip->end_time == 0 && db_partition_rotate(db)) {
+		trip_current_rowid = 0;
+		db_boot_rowid	   = 0;
+	}
+	checkpoint_save_trip(&trip_current, trip_current_rowid);
 
 cleanup:
-	sqlite3_finalize(stmt);
-	free(trip);
+	db_release(stmt);
 	pthread_mutex_unlock(&db_mutex);
 }
 
-static void db_process_trips_thread(void *arg) {
+/**
+ * Run all statements of 'sql', binding 'params' to ?1, ?2, ... of each one.
+ */
+static bool db_exec_bind(const char *sql, const long long *params, int count) {
+	sqlite3_stmt *stmt = NULL;
+	const char *tail   = sql;
+	while (*tail != '\0') {
+		if (sqlite3_prepare_v2(db, tail, -1, &stmt, &tail) != SQLITE_OK)
+			SQLITE3_ERROR("sqlite3_prepare_v2()", return false);
+		for (int i = 0; i < count; i++) {
+			sqlite3_bind_int64(stmt, i + 1, params[i]);
+		}
+		if (sqlite3_step(stmt) != SQLITE_DONE)
+			SQLITE3_ERROR("sqlite3_step()", sqlite3_finalize(stmt); return false);
+		sqlite3_finalize(stmt);
+	}
+	return true;
+}
+
+/**
+ * Shift records and alerts saved since db_connect(), and the trips built from these records, then rebuild the totals.
+ *
+ * WAL transactions are not atomic across attached databases, so the main database is written first, along with
+ * a row of the reanchor table - the records are shifted in their partition afterwards (see db_reanchor_records()),
+ * or by db_connect() if that was interrupted.
+ */
+static void db_reanchor_job(long long delta) {
 	pthread_mutex_lock(&db_mutex);
 
+	bool commit			  = false;
+	long long reanchor_id = 0;
+	long long last_rowid  = 0;
+	sqlite3_stmt *stmt	  = NULL;
+	if (sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(BEGIN)", goto cleanup);
+
+	// records saved from now on are already anchored correctly
+	if (sqlite3_prepare_v2(db, "SELECT IFNULL(MAX(rowid), 0) FROM record;", -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		last_rowid = sqlite3_column_int64(stmt, 0);
+
+	const char *sql = (
+		// reanchor
+		"INSERT INTO reanchor (delta, first_rowid, last_rowid) VALUES (?1, ?2, ?4);"
+		// trip
+		"UPDATE trip "
+		"SET start_time = start_time + ?1, end_time = end_time + ?1 "
+		"WHERE trip_id IN (SELECT trip_id FROM record WHERE rowid > ?2 AND rowid <= ?4);"
+		// alert
+		"UPDATE alert "
+		"SET start_time = start_time + ?1, end_time = end_time + ?1 "
+		"WHERE alert_id > ?3;"
+		// trip_stats
+		"DELETE FROM trip_stats;" TRIP_STATS_BUILD
+	);
+	long long params[] = {delta, db_boot_rowid, db_boot_alert_id, last_rowid};
+	if (!db_exec_bind(sql, params, 4))
+		goto cleanup;
+	reanchor_id = sqlite3_last_insert_rowid(db);
+	commit		= true;
+
+cleanup:
+	sqlite3_finalize(stmt);
+	if (sqlite3_exec(db, commit ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(COMMIT)", commit = false);
+	if (commit) {
+		db_reanchor_records(reanchor_id, delta, db_boot_rowid, last_rowid);
+		// the trip in progress was built from the same records
+		if (trip_current.end_time != 0) {
+			trip_current.start_time += delta;
+			trip_current.end_time += delta;
+		}
+	}
+	// records saved before this job were converted with the old anchor - new ones are converted with the new one
+	clock_reanchor(delta);
+	if (commit)
+		checkpoint_save_trip(&trip_current, trip_current_rowid);
+	pthread_mutex_unlock(&db_mutex);
+
+	// update trip_current in the database
+	db_process_trips_job();
+}
+
+/**
+ * Shift records of a re-anchoring in the partition, unless the partition marks it as done already, then remove it from
+ * the main database.
+ */
+static bool db_reanchor_records(long long reanchor_id, long long delta, long long first_rowid, long long last_rowid) {
+	bool commit = false;
+	if (sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(BEGIN)", return false);
 	const char *sql = (
 		// record
-		"SELECT "
-		"start_time, end_time, start_mileage, end_mileage, "
-		"dist, fuel, engine_speed, engine_speed_max, "
-		"vehicle_speed_min, vehicle_speed_max, "
-		"coolant_temp, outside_temp, oil_temp, oil_level, "
-		"fuel_level, fuel_range, fuel_cons_min, fuel_cons_max "
-		"FROM record "
-		"WHERE trip_id IS NULL "
-		"ORDER BY start_time;"
+		"UPDATE record "
+		"SET start_time = start_time + ?2, end_time = end_time + ?2 "
+		"WHERE rowid > ?3 AND rowid <= ?4 "
+		"AND NOT EXISTS (SELECT 1 FROM record_reanchor WHERE reanchor_id = ?1);"
+		// record_reanchor
+		"INSERT OR IGNORE INTO record_reanchor (reanchor_id) VALUES (?1);"
 	);
+	long long params[] = {reanchor_id, delta, first_rowid, last_rowid};
+	commit			   = db_exec_bind(sql, params, 4);
+	if (sqlite3_exec(db, commit ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(COMMIT)", commit = false);
+	if (!commit)
+		LT_ERR(E, return false, "Database: cannot re-anchor records, retried on the next start");
 
-	sqlite3_stmt *stmt = NULL;
-	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
-		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+	sql = (
+		// reanchor
+		"DELETE FROM reanchor WHERE reanchor_id = ?1;"
+		// record_reanchor - IDs are never reused, so this may be left behind
+		"DELETE FROM record_reanchor WHERE reanchor_id = ?1;"
+	);
+	return db_exec_bind(sql, params, 1);
+}
 
-	trip_t trip		= {0};
-	record_t record = {0};
-	trip_reset(&trip);
-	record_reset(&record);
+/**
+ * Finish re-anchorings of records interrupted by a power cut. Called by db_connect().
+ */
+static bool db_reanchor_resume() {
+	const char *sql = (
+		// reanchor
+		"SELECT reanchor_id, delta, first_rowid, last_rowid FROM reanchor "
+		"WHERE reanchor_id > ? ORDER BY reanchor_id LIMIT 1;"
+	);
 
+	long long reanchor_id = 0;
 	while (1) {
-		int ret = sqlite3_step(stmt);
-		if (ret == SQLITE_BUSY) {
-			sleep(1);
-			continue;
+		sqlite3_stmt *stmt = NULL;
+		if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+			SQLITE3_ERROR("sqlite3_prepare_v2()", return false);
+		sqlite3_bind_int64(stmt, 1, reanchor_id);
+		if (sqlite3_step(stmt) != SQLITE_ROW) {
+			sqlite3_finalize(stmt);
+			return true;
 		}
-		if (ret == SQLITE_DONE)
-			break;
-		if (ret != SQLITE_ROW)
-			SQLITE3_ERROR("sqlite3_step()", goto cleanup);
+		reanchor_id			  = sqlite3_column_int64(stmt, 0);
+		long long delta		  = sqlite3_column_int64(stmt, 1);
+		long long first_rowid = sqlite3_column_int64(stmt, 2);
+		long long last_rowid  = sqlite3_column_int64(stmt, 3);
+		sqlite3_finalize(stmt);
+		LT_WM(DB, "finishing re-anchoring of records by %lld ms", delta);
+		if (!db_reanchor_records(reanchor_id, delta, first_rowid, last_rowid))
+			return false;
+	}
+}
 
-		record.start.time		 = sqlite3_column_int64(stmt, 0);
-		record.end.time			 = sqlite3_column_int64(stmt, 1);
-		record.start.mileage	 = sqlite3_column_double(stmt, 2);
-		record.end.mileage		 = sqlite3_column_double(stmt, 3);
-		record.dist				 = sqlite3_column_int(stmt, 4);
-		record.fuel				 = sqlite3_column_int(stmt, 5);
-		record.engine_speed.avg	 = sqlite3_column_double(stmt, 6);
-		record.engine_speed.max	 = sqlite3_column_double(stmt, 7);
-		record.vehicle_speed.min = sqlite3_column_double(stmt, 8);
-		record.vehicle_speed.max = sqlite3_column_double(stmt, 9);
-		record.coolant_temp.avg	 = sqlite3_column_double(stmt, 10);
-		record.outside_temp.avg	 = sqlite3_column_double(stmt, 11);
-		record.oil_temp.avg		 = sqlite3_column_double(stmt, 12);
-		record.oil_level.avg	 = sqlite3_column_double(stmt, 13);
-		record.fuel_level.avg	 = sqlite3_column_double(stmt, 14);
-		record.fuel_range.avg	 = sqlite3_column_double(stmt, 15);
-		record.fuel_cons.min	 = sqlite3_column_double(stmt, 16);
-		record.fuel_cons.max	 = sqlite3_column_double(stmt, 17);
-
-		if (trip.end_time != 0 && (record.end.time - trip.end_time) > 5 * 60 * 1000) {
-			// start a new trip if there was no record for 5 min
-			db_save_trip(&trip);
-			trip_print(&trip);
-			trip_reset(&trip);
-		}
+static void db_standby_job() {
+	// jobs queued before (i.e. saving the last record) are already done
+	pthread_mutex_lock(&db_mutex);
+
+	// move everything from the WAL to the database, so that nothing is written while parked
+	if (sqlite3_wal_checkpoint_v2(db, NULL, SQLITE_CHECKPOINT_TRUNCATE, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_wal_checkpoint_v2()", );
+	// give back page cache and statement memory, unless already woken up (and prewarmed) again
+	long long used = sqlite3_memory_used();
+	if (power_get() == POWER_STATE_STANDBY) {
+		db_finalize_cached();
+		sqlite3_db_release_memory(db);
+	}
+	LT_IM(DB, "standby, WAL checkpointed, released %lld bytes", used - sqlite3_memory_used());
+
+	pthread_mutex_unlock(&db_mutex);
+}
+
+static void db_prewarm_job() {
+	pthread_mutex_lock(&db_mutex);
+	unsigned long long start = metric_time_us();
+
+	// prepare statements of the record path, which also loads the schema
+	if (!db_prepare_cached(&db_record_insert, db_sql_record_insert) ||
+		!db_prepare_cached(&db_record_select, db_sql_record_select))
+		goto cleanup;
+	// read the pages that the first record and trip updates will touch
+	if (sqlite3_exec(db, "SELECT MAX(rowid) FROM record; SELECT * FROM trip_current;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(SELECT)", goto cleanup);
+	LT_IM(DB, "prewarmed in %llu us", metric_time_us() - start);
+
+cleanup:
+	pthread_mutex_unlock(&db_mutex);
+}
+
+static bool db_prepare_cached(sqlite3_stmt **stmt, const char *sql) {
+	if (*stmt != NULL)
+		return true;
+	if (sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v3()", return false);
+	return true;
+}
+
+static void db_release(sqlite3_stmt *stmt) {
+	// cached statements are only reset, to be used again
+	if (stmt != NULL && (stmt == db_record_insert || stmt == db_record_select)) {
+		sqlite3_reset(stmt);
+		sqlite3_clear_bindings(stmt);
+		return;
+	}
+	sqlite3_finalize(stmt);
+}
+
+static void db_finalize_cached() {
+	sqlite3_finalize(db_record_insert);
+	sqlite3_finalize(db_record_select);
+	db_record_insert = NULL;
+	db_record_select = NULL;
+}
+
+static bool db_table_exists(const char *name) {
+	sqlite3_stmt *stmt = NULL;
+	bool ret		   = false;
+	if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?;", -1, &stmt, NULL) ==
+		SQLITE_OK) {
+		sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+		ret = sqlite3_step(stmt) == SQLITE_ROW;
+	}
+	sqlite3_finalize(stmt);
+	return ret;
+}
+
+static bool db_migrate_begin(bool *migrate) {
+	sqlite3_stmt *stmt = NULL;
+	int version		   = 0;
+	if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", return false);
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		version = sqlite3_column_int(stmt, 0);
+	sqlite3_finalize(stmt);
+
+	// columns were stored as REAL before version 1
+	*migrate = version < 1 && db_table_exists("record");
+	if (!*migrate)
+		return true;
+	LT_IM(DB, "migrating from version %d to %d", version, DB_VERSION);
 
-		// add this record to the trip
-		trip_append(&trip, &record);
+	if (sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(BEGIN)", return false);
+	for (size_t i = 0; i < sizeof(db_scaled_tables) / sizeof(*db_scaled_tables); i++) {
+		if (!db_table_exists(db_scaled_tables[i]))
+			continue;
+		const char *table = db_scaled_tables[i];
+		char *sql		  = sqlite3_mprintf("ALTER TABLE \"%w\" RENAME TO \"%w_old\";", table, table);
+		int ret			  = sqlite3_exec(db, sql, NULL, NULL, NULL);
+		sqlite3_free(sql);
+		if (ret != SQLITE_OK)
+			SQLITE3_ERROR("sqlite3_exec(ALTER TABLE)", goto error);
 	}
+	return true;
 
-	if (trip.end_time != 0 && (millis() - trip.end_time) > 5 * 60 * 1000) {
-		// save the last records if they are older than 5 min
-		db_save_trip(&trip);
-		trip_print(&trip);
+error:
+	sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+	return false;
+}
+
+static bool db_migrate_table(const char *table) {
+	char *sql = NULL, *columns = NULL, *values = NULL;
+	size_t columns_size = 0, values_size = 0;
+	FILE *columns_file = open_memstream(&columns, &columns_size);
+	FILE *values_file  = open_memstream(&values, &values_size);
+	sqlite3_stmt *stmt = NULL;
+	bool ret		   = false;
+	if (columns_file == NULL || values_file == NULL)
+		LT_ERR(E, goto cleanup, "Database: cannot allocate migration query");
+
+	// copy all columns, converting REAL values of scaled columns;
+	// record rowids are kept, as they're used by db_reanchor() and fleet sync
+	if (strcmp(table, "record") == 0) {
+		fprintf(columns_file, "rowid");
+		fprintf(values_file, "rowid");
 	}
+	sql = sqlite3_mprintf("PRAGMA table_info(\"%w_old\");", table);
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+	sqlite3_free(sql);
+	sql = NULL;
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		const char *column = (const char *)sqlite3_column_text(stmt, 1);
+		int scale		   = 0;
+		for (size_t i = 0; i < sizeof(db_scales) / sizeof(*db_scales); i++) {
+			if (strcmp(db_scales[i].column, column) == 0)
+				scale = db_scales[i].scale;
+		}
+		const char *sep = ftell(columns_file) ? ", " : "";
+		fprintf(columns_file, "%s\"%s\"", sep, column);
+		if (scale != 0)
+			fprintf(values_file, "%sCAST(round(\"%s\" * %d) AS INTEGER)", sep, column, scale);
+		else
+			fprintf(values_file, "%s\"%s\"", sep, column);
+	}
+	sqlite3_finalize(stmt);
+	stmt = NULL;
+	fclose(columns_file);
+	fclose(values_file);
+	columns_file = values_file = NULL;
+
+	sql = sqlite3_mprintf(
+		"INSERT INTO \"%w\" (%s) SELECT %s FROM \"%w_old\"; DROP TABLE \"%w_old\";",
+		table,
+		columns,
+		values,
+		table,
+		table
+	);
+	if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(INSERT)", goto cleanup);
+	LT_IM(DB, "migrated %s, %d rows", table, sqlite3_changes(db));
+	ret = true;
 
 cleanup:
 	sqlite3_finalize(stmt);
-	pthread_mutex_unlock(&db_mutex);
+	sqlite3_free(sql);
+	if (columns_file != NULL)
+		fclose(columns_file);
+	if (values_file != NULL)
+		fclose(values_file);
+	free(columns);
+	free(values);
+	return ret;
+}
+
+static bool db_migrate_end() {
+	for (size_t i = 0; i < sizeof(db_scaled_tables) / sizeof(*db_scaled_tables); i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "%s_old", db_scaled_tables[i]);
+		if (db_table_exists(name) && !db_migrate_table(db_scaled_tables[i]))
+			goto error;
+	}
+	// trip_stats was built by db_connect() while the trips were still in trip_old
+	if (sqlite3_exec(db, "DELETE FROM trip_stats;" TRIP_STATS_BUILD, NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(trip_stats)", goto error);
+	if (sqlite3_exec(db, "PRAGMA user_version = " STRINGIFY(DB_VERSION) "; COMMIT;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(COMMIT)", goto error);
+
+	// rewrite the file to actually release the space
+	sqlite3_exec(db, "PRAGMA wal_checkpoint(TRUNCATE);", NULL, NULL, NULL);
+	long long size = db_size_main();
+	if (sqlite3_exec(db, "VACUUM; PRAGMA wal_checkpoint(TRUNCATE);", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(VACUUM)", return true);
+	LT_IM(DB, "database size %lld -> %lld bytes", size, db_size_main());
+	return true;
+
+error:
+	sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+	return false;
+}
+
+static void db_bind_trip(sqlite3_stmt *stmt, int index, trip_t *trip) {
+	sqlite3_bind_int(stmt, index, (int)trip->time);
+	sqlite3_bind_int(stmt, index + 1, (int)trip->dist);
+	sqlite3_bind_int(stmt, index + 2, (int)trip->fuel);
+	sqlite3_bind_int64(stmt, index + 3, (long long)trip->start_time);
+	sqlite3_bind_int64(stmt, index + 4, (long long)trip->end_time);
+	db_bind_scaled(stmt, index + 5, trip->start_mileage, start_mileage);
+	db_bind_scaled(stmt, index + 6, trip->end_mileage, end_mileage);
+	db_bind_scaled(stmt, index + 7, trip->engine_speed.max, engine_speed_max);
+	db_bind_scaled(stmt, index + 8, trip->vehicle_speed.max, vehicle_speed_max);
+	db_bind_scaled(stmt, index + 9, trip->coolant_temp.avg, coolant_temp_avg);
+	db_bind_scaled(stmt, index + 10, trip->coolant_temp.min, coolant_temp_min);
+	db_bind_scaled(stmt, index + 11, trip->coolant_temp.max, coolant_temp_max);
+	db_bind_scaled(stmt, index + 12, trip->outside_temp.avg, outside_temp_avg);
+	db_bind_scaled(stmt, index + 13, trip->outside_temp.min, outside_temp_min);
+	db_bind_scaled(stmt, index + 14, trip->outside_temp.max, outside_temp_max);
+	db_bind_scaled(stmt, index + 15, trip->oil_temp.avg, oil_temp_avg);
+	db_bind_scaled(stmt, index + 16, trip->oil_temp.min, oil_temp_min);
+	db_bind_scaled(stmt, index + 17, trip->oil_temp.max, oil_temp_max);
+	db_bind_scaled(stmt, index + 18, trip->oil_level.min, oil_level_min);
+	db_bind_scaled(stmt, index + 19, trip->oil_level.max, oil_level_max);
+	db_bind_scaled(stmt, index + 20, trip->fuel_level.min, fuel_level_min);
+	db_bind_scaled(stmt, index + 21, trip->fuel_level.max, fuel_level_max);
+	db_bind_scaled(stmt, index + 22, trip->fuel_range.min, fuel_range_min);
+	db_bind_scaled(stmt, index + 23, trip->fuel_range.max, fuel_range_max);
+	db_bind_scaled(stmt, index + 24, trip->fuel_cons.min, fuel_cons_min);
+	db_bind_scaled(stmt, index + 25, trip->fuel_cons.max, fuel_cons_max);
+}
+
+static long long db_file_size(const char *suffix) {
+	if (db_filename == NULL)
+		return 0;
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s%s", db_filename, suffix);
+	struct stat st;
+	if (stat(path, &st) != 0)
+		return 0;
+	return st.st_size;
+}
+
+static long long db_size_main() {
+	return db_file_size("");
+}
+
+static long long db_size_wal() {
+	// WAL pages not checkpointed into the database yet
+	return db_file_size("-wal");
 }
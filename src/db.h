@@ -4,11 +4,32 @@
 
 #include "include.h"
 
+#include "db_heap.h"
+#include "db_partition.h"
+#include "db_scale.h"
+
+#define DB_VERSION 2 // PRAGMA user_version of the current schema
+
+// record columns read by db_column_record()
+#define DB_RECORD_SELECT                                                                                               \
+	"start_time, end_time, start_mileage, end_mileage, dist, fuel, engine_speed, engine_speed_max, "                   \
+	"vehicle_speed_min, vehicle_speed_max, coolant_temp, outside_temp, oil_temp, oil_level, fuel_level, fuel_range, "  \
+	"fuel_cons_min, fuel_cons_max"
+
+typedef struct alert_t alert_t;
 typedef struct record_t record_t;
 typedef struct trip_t trip_t;
 
 sqlite3 *db_connect(const char *filename);
 void db_close();
 void db_save_record(record_t *record);
-void db_save_trip(trip_t *trip);
+void db_save_alert(alert_t *alert);
 void db_process_trips();
+void db_reanchor(long long delta);
+void db_standby();
+void db_prewarm();
+bool db_restore_trip(trip_t *trip, long long rowid);
+bool db_has_record(unsigned long long start_time);
+bool db_replace_trips(trip_t *trips, size_t count, trip_t *current);
+void db_column_record(sqlite3_stmt *stmt, int index, record_t *record);
+void db_wait();
@@ -0,0 +1,183 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#include "db_heap.h"
+
+// A buddy allocator over a static buffer (like SQLite's memsys5, which is usually not compiled in).
+// Blocks are DB_HEAP_MIN << level bytes, and start at a multiple of their size.
+
+#define DB_HEAP_MIN		  64 // smallest block, also holds the free list links
+#define DB_HEAP_BLOCKS	  (DATABASE_HEAP_SIZE / DB_HEAP_MIN)
+#define DB_HEAP_LEVEL_MAX 31
+#define DB_HEAP_FREE	  0x80 // control byte flag of free blocks
+#define DB_HEAP_PAGE_SIZE (4096 + 256) // page cache slot - page and its header (see SQLITE_CONFIG_PCACHE_HDRSZ)
+
+_Static_assert((DATABASE_HEAP_SIZE & (DATABASE_HEAP_SIZE - 1)) == 0, "Heap size must be a power of 2");
+_Static_assert(DATABASE_HEAP_SIZE >= DB_HEAP_MIN, "Heap size too small");
+
+typedef struct db_heap_link_t {
+	int next;
+	int prev;
+} db_heap_link_t;
+
+static uint8_t db_heap[DATABASE_HEAP_SIZE] __attribute__((aligned(DB_HEAP_MIN)));
+static uint8_t db_heap_ctrl[DB_HEAP_BLOCKS];	//!< Level of the block starting at each index, with DB_HEAP_FREE
+static int db_heap_list[DB_HEAP_LEVEL_MAX + 1]; //!< First free block of each level, -1 if none
+static int db_heap_levels			 = 0;		//!< Level of the whole heap
+static pthread_mutex_t db_heap_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint8_t db_page_cache[DATABASE_PAGE_CACHE * DB_HEAP_PAGE_SIZE] __attribute__((aligned(64)));
+
+static long long db_heap_used();
+static long long db_heap_peak();
+
+static metric_t metric_db_heap[] METRIC_SECTION = {
+	METRIC_GAUGE_READ("triplogger_db_heap_bytes", "type=\"used\"", "Memory used by SQLite", db_heap_used),
+	METRIC_GAUGE_READ("triplogger_db_heap_bytes", "type=\"peak\"", "Memory used by SQLite", db_heap_peak),
+};
+
+#define db_heap_link(index) ((db_heap_link_t *)&db_heap[(size_t)(index) * DB_HEAP_MIN])
+
+static void db_heap_push(int index, int level) {
+	db_heap_link(index)->prev = -1;
+	db_heap_link(index)->next = db_heap_list[level];
+	if (db_heap_list[level] >= 0)
+		db_heap_link(db_heap_list[level])->prev = index;
+	db_heap_list[level] = index;
+	db_heap_ctrl[index] = level | DB_HEAP_FREE;
+}
+
+static void db_heap_unlink(int index, int level) {
+	db_heap_link_t *link = db_heap_link(index);
+	if (link->prev >= 0)
+		db_heap_link(link->prev)->next = link->next;
+	else
+		db_heap_list[level] = link->next;
+	if (link->next >= 0)
+		db_heap_link(link->next)->prev = link->prev;
+}
+
+static int db_heap_level(int size) {
+	int level = 0;
+	while ((DB_HEAP_MIN << level) < size)
+		level++;
+	return level;
+}
+
+static void *db_heap_malloc(int size) {
+	if (size <= 0 || size > DATABASE_HEAP_SIZE)
+		return NULL;
+	int level = db_heap_level(size);
+	pthread_mutex_lock(&db_heap_mutex);
+	// take the smallest free block that fits, and split it down to the needed size
+	int found = level;
+	while (found <= db_heap_levels && db_heap_list[found] < 0)
+		found++;
+	if (found > db_heap_levels) {
+		pthread_mutex_unlock(&db_heap_mutex);
+		return NULL;
+	}
+	int index = db_heap_list[found];
+	db_heap_unlink(index, found);
+	while (found > level) {
+		found--;
+		db_heap_push(index + (1 << found), found);
+	}
+	db_heap_ctrl[index] = level;
+	pthread_mutex_unlock(&db_heap_mutex);
+	return db_heap_link(index);
+}
+
+static void db_heap_free(void *ptr) {
+	if (ptr == NULL)
+		return;
+	int index = (int)(((uint8_t *)ptr - db_heap) / DB_HEAP_MIN);
+	pthread_mutex_lock(&db_heap_mutex);
+	int level = db_heap_ctrl[index];
+	// merge with the buddy for as long as it's free
+	while (level < db_heap_levels) {
+		int buddy = index ^ (1 << level);
+		if (db_heap_ctrl[buddy] != (level | DB_HEAP_FREE))
+			break;
+		db_heap_unlink(buddy, level);
+		db_heap_ctrl[max(index, buddy)] = 0;
+		index							= min(index, buddy);
+		level++;
+	}
+	db_heap_push(index, level);
+	pthread_mutex_unlock(&db_heap_mutex);
+}
+
+static int db_heap_size(void *ptr) {
+	if (ptr == NULL)
+		return 0;
+	return DB_HEAP_MIN << (db_heap_ctrl[((uint8_t *)ptr - db_heap) / DB_HEAP_MIN] & ~DB_HEAP_FREE);
+}
+
+static void *db_heap_realloc(void *ptr, int size) {
+	// blocks are only moved when they grow past their size
+	int old_size = db_heap_size(ptr);
+	if (size <= old_size)
+		return ptr;
+	void *new = db_heap_malloc(size);
+	if (new == NULL)
+		return NULL;
+	memcpy(new, ptr, old_size);
+	db_heap_free(ptr);
+	return new;
+}
+
+static int db_heap_roundup(int size) {
+	return DB_HEAP_MIN << db_heap_level(size);
+}
+
+static int db_heap_setup(void *arg) {
+	for (int level = 0; level <= DB_HEAP_LEVEL_MAX; level++) {
+		db_heap_list[level] = -1;
+	}
+	db_heap_levels = db_heap_level(DATABASE_HEAP_SIZE);
+	db_heap_push(0, db_heap_levels);
+	return SQLITE_OK;
+}
+
+static void db_heap_shutdown(void *arg) {}
+
+/**
+ * Give SQLite fixed memory - a static heap and page cache - before it's first used. Its memory use stays
+ * bounded, and it never calls malloc(). Must be called before any other SQLite function.
+ */
+bool db_heap_init() {
+	static const sqlite3_mem_methods methods = {
+		.xMalloc   = db_heap_malloc,
+		.xFree	   = db_heap_free,
+		.xRealloc  = db_heap_realloc,
+		.xSize	   = db_heap_size,
+		.xRoundup  = db_heap_roundup,
+		.xInit	   = db_heap_setup,
+		.xShutdown = db_heap_shutdown,
+	};
+	int hdr_size = 0;
+	if (sqlite3_config(SQLITE_CONFIG_PCACHE_HDRSZ, &hdr_size) != SQLITE_OK)
+		LT_ERR(E, return false, "Database: SQLite already initialized, cannot configure memory");
+	if (sqlite3_config(SQLITE_CONFIG_MALLOC, &methods) != SQLITE_OK)
+		LT_ERR(E, return false, "Database: cannot configure the heap");
+	// pages and their headers are in one slot
+	int slot_size = 4096 + ((hdr_size + 7) & ~7);
+	if (slot_size <= DB_HEAP_PAGE_SIZE &&
+		sqlite3_config(SQLITE_CONFIG_PAGECACHE, db_page_cache, slot_size, (int)(sizeof(db_page_cache) / slot_size)) !=
+			SQLITE_OK)
+		LT_WM(DB, "cannot configure the page cache");
+	// connections carve their lookaside out of the heap (if SQLite is built with lookaside)
+	sqlite3_config(SQLITE_CONFIG_LOOKASIDE, 128, 128);
+	// free cached pages before the heap runs out
+	sqlite3_soft_heap_limit64(DATABASE_HEAP_SIZE / 4 * 3);
+	LT_IM(DB, "heap %d KiB, page cache %d KiB", DATABASE_HEAP_SIZE / 1024, (int)(sizeof(db_page_cache) / 1024));
+	return true;
+}
+
+static long long db_heap_used() {
+	return sqlite3_memory_used();
+}
+
+static long long db_heap_peak() {
+	return sqlite3_memory_highwater(false);
+}
@@ -0,0 +1,340 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#include "db_partition.h"
+
+#include <libgen.h>
+
+static char partition_name[32]		  = {0}; //!< Period of the current partition
+static char partition_path[PATH_MAX]  = {0}; //!< Path of the current partition file
+static char partition_dir[PATH_MAX]	  = {0}; //!< Directory of the main database
+static char partition_prefix[NAME_MAX] = {0}; //!< Main database file name, without the .db extension
+
+static const char *db_sql_record_create = (
+	// record
+	"CREATE TABLE IF NOT EXISTS \"%w\".record ("
+	"start_time INTEGER NOT NULL, "
+	"end_time INTEGER NOT NULL, "
+	"start_mileage INTEGER NOT NULL, "
+	"end_mileage INTEGER NOT NULL, "
+	"dist INTEGER NOT NULL, "
+	"fuel INTEGER NOT NULL, "
+	"engine_speed INTEGER NOT NULL, "
+	"engine_speed_max INTEGER NOT NULL, "
+	"vehicle_speed_min INTEGER NOT NULL, "
+	"vehicle_speed_max INTEGER NOT NULL, "
+	"coolant_temp INTEGER NOT NULL, "
+	"outside_temp INTEGER NOT NULL, "
+	"oil_temp INTEGER NOT NULL, "
+	"oil_level INTEGER NOT NULL, "
+	"fuel_level INTEGER NOT NULL, "
+	"fuel_range INTEGER NOT NULL, "
+	"fuel_cons_min INTEGER NOT NULL, "
+	"fuel_cons_max INTEGER NOT NULL, "
+	"trip_id INTEGER DEFAULT NULL, "
+	"PRIMARY KEY(start_time, end_time)"
+	");"
+);
+
+// all columns, for copying records between partitions (with their rowid)
+#define DB_RECORD_COLUMNS                                                                                              \
+	"rowid, start_time, end_time, start_mileage, end_mileage, dist, fuel, engine_speed, engine_speed_max, "            \
+	"vehicle_speed_min, vehicle_speed_max, coolant_temp, outside_temp, oil_temp, oil_level, fuel_level, "              \
+	"fuel_range, fuel_cons_min, fuel_cons_max, trip_id"
+
+// period of a record (ms), in SQL
+#define DB_RECORD_PERIOD "strftime('" DATABASE_PARTITION "', start_time / 1000, 'unixepoch')"
+
+static void db_partition_period(unsigned long long time, char *name, size_t size) {
+	time_t seconds = (time_t)(time / 1000);
+	struct tm tm;
+	gmtime_r(&seconds, &tm);
+	strftime(name, size, DATABASE_PARTITION, &tm);
+}
+
+static bool db_partition_file(const char *name, char *file, size_t size) {
+	// i.e. canlogger-2026-10.db, next to canlogger.db
+	int len = snprintf(file, size, "%s-%s.db", partition_prefix, name);
+	if (len < 0 || (size_t)len >= size)
+		LT_ERR(E, return false, "Database: file name of partition %s is too long", name);
+	return true;
+}
+
+static bool db_partition_path(const char *name, char *path, size_t size) {
+	char file[NAME_MAX + 1];
+	if (!db_partition_file(name, file, sizeof(file)))
+		return false;
+	int len = snprintf(path, size, "%s/%s", partition_dir, file);
+	if (len < 0 || (size_t)len >= size)
+		LT_ERR(E, return false, "Database: path of partition %s is too long", name);
+	return true;
+}
+
+static bool db_partition_exec(sqlite3 *db, char *sql) {
+	int ret = sqlite3_exec(db, sql, NULL, NULL, NULL);
+	if (ret != SQLITE_OK)
+		LT_E("Database: '%.40s...' failed; errmsg: %s", sql, sqlite3_errmsg(db));
+	sqlite3_free(sql);
+	return ret == SQLITE_OK;
+}
+
+/**
+ * Create the record table in 'schema' - a partition, or "main" when migrating older databases.
+ */
+bool db_partition_create_table(sqlite3 *db, const char *schema) {
+	return db_partition_exec(db, sqlite3_mprintf(db_sql_record_create, schema));
+}
+
+static bool db_partition_attach(sqlite3 *db, const char *schema, const char *name) {
+	char file[NAME_MAX + 1];
+	if (!db_partition_file(name, file, sizeof(file)))
+		return false;
+	char *sql = sqlite3_mprintf(
+		"INSERT OR IGNORE INTO record_partition (name, file) VALUES (%Q, %Q);"
+		"ATTACH DATABASE '%q/%q' AS \"%w\";"
+		"PRAGMA \"%w\".journal_mode = WAL;",
+		name,
+		file,
+		partition_dir,
+		file,
+		schema,
+		schema
+	);
+	if (!db_partition_exec(db, sql) || !db_partition_create_table(db, schema))
+		return false;
+	// re-anchorings already applied to the records of this partition (see db_reanchor_records())
+	sql = sqlite3_mprintf(
+		"CREATE TABLE IF NOT EXISTS \"%w\".record_reanchor (reanchor_id INTEGER NOT NULL PRIMARY KEY);",
+		schema
+	);
+	return db_partition_exec(db, sql);
+}
+
+static bool db_partition_close(sqlite3 *db, const char *schema, const char *name) {
+	char path[PATH_MAX];
+	if (!db_partition_path(name, path, sizeof(path)))
+		return false;
+
+	// store the time range, so that readers only attach partitions they need
+	char *sql = sqlite3_mprintf(
+		"UPDATE record_partition SET "
+		"start_time = (SELECT IFNULL(MIN(start_time), 0) FROM \"%w\".record), "
+		"end_time = (SELECT IFNULL(MAX(end_time), 0) FROM \"%w\".record) "
+		"WHERE name = %Q;",
+		schema,
+		schema,
+		name
+	);
+	if (!db_partition_exec(db, sql))
+		return false;
+	// make it a single self-contained file (fails if a reader still has it open in WAL mode)
+	sql = sqlite3_mprintf(
+		"PRAGMA \"%w\".wal_checkpoint(TRUNCATE); PRAGMA \"%w\".journal_mode = DELETE;",
+		schema,
+		schema
+	);
+	if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
+		LT_WM(DB, "partition %s left in WAL mode: %s", name, sqlite3_errmsg(db));
+	sqlite3_free(sql);
+	if (!db_partition_exec(db, sqlite3_mprintf("DETACH DATABASE \"%w\";", schema)))
+		return false;
+	// closed partitions are never written again (except when rebuilding trips)
+	chmod(path, 0444);
+	LT_IM(DB, "partition %s closed", name);
+	return true;
+}
+
+static bool db_partition_split(sqlite3 *db) {
+	// records of each period go to their own partition - except for records not assigned to any trip yet,
+	// which go to the last (current) partition, as only that one is read when processing trips
+	LT_IM(DB, "splitting record table into partitions");
+	char(*names)[32]   = NULL;
+	int count		   = 0;
+	sqlite3_stmt *stmt = NULL;
+	bool ret		   = false;
+	if (sqlite3_prepare_v2(db, "SELECT DISTINCT " DB_RECORD_PERIOD " FROM main.record ORDER BY 1;", -1, &stmt, NULL) !=
+		SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", return false);
+	// read all periods first - attaching databases expires running statements
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		void *grown = realloc(names, (count + 1) * sizeof(*names));
+		if (grown == NULL)
+			LT_ERR(E, goto cleanup, "Database: cannot allocate partition names");
+		names = grown;
+		strncpy2(names[count++], (const char *)sqlite3_column_text(stmt, 0), sizeof(*names) - 1);
+	}
+	sqlite3_finalize(stmt);
+	stmt = NULL;
+
+	for (int i = 0; i < count; i++) {
+		const char *name = names[i];
+		bool current	 = i == count - 1;
+		// repeated from scratch if interrupted - the source table is only dropped at the end
+		char path[PATH_MAX];
+		if (!db_partition_path(name, path, sizeof(path)))
+			goto cleanup;
+		chmod(path, 0644);
+		if (!db_partition_attach(db, "split", name))
+			goto cleanup;
+		if (!db_partition_exec(db, sqlite3_mprintf("DELETE FROM split.record;")))
+			goto cleanup;
+		const char *sql = (
+			// record
+			"INSERT INTO split.record (" DB_RECORD_COLUMNS ") "
+			"SELECT " DB_RECORD_COLUMNS " FROM main.record "
+			"WHERE " DB_RECORD_PERIOD " = ?1 AND (trip_id IS NOT NULL OR ?2) "
+			"OR trip_id IS NULL AND ?2;"
+		);
+		if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+			SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+		sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+		sqlite3_bind_int(stmt, 2, current);
+		if (sqlite3_step(stmt) != SQLITE_DONE)
+			SQLITE3_ERROR("sqlite3_step()", goto cleanup);
+		sqlite3_finalize(stmt);
+		stmt = NULL;
+		LT_IM(DB, "partition %s: %d records", name, sqlite3_changes(db));
+		if (current) {
+			if (!db_partition_exec(db, sqlite3_mprintf("DETACH DATABASE split;")))
+				goto cleanup;
+			strcpy(partition_name, name);
+		} else if (!db_partition_close(db, "split", name)) {
+			goto cleanup;
+		}
+	}
+
+	ret = db_partition_exec(db, sqlite3_mprintf("DROP TABLE main.record; VACUUM;"));
+
+cleanup:
+	sqlite3_finalize(stmt);
+	free(names);
+	if (!ret)
+		sqlite3_exec(db, "DETACH DATABASE split;", NULL, NULL, NULL);
+	return ret;
+}
+
+/**
+ * Attach the current record partition, creating it if needed. Databases with a single record table
+ * (written by older versions) are split into partitions first. Called by db_connect().
+ */
+bool db_partition_open(sqlite3 *db, const char *filename) {
+	char copy[PATH_MAX];
+	strncpy2(copy, filename, sizeof(copy) - 1);
+	strncpy2(partition_dir, dirname(copy), sizeof(partition_dir) - 1);
+	strncpy2(copy, filename, sizeof(copy) - 1);
+	strncpy2(partition_prefix, basename(copy), sizeof(partition_prefix) - 1);
+	char *ext = strrchr(partition_prefix, '.');
+	if (ext != NULL && strcmp(ext, ".db") == 0)
+		*ext = '\0';
+	partition_name[0] = '\0';
+
+	const char *sql = (
+		// record_partition - the current partition has no time range yet
+		"CREATE TABLE IF NOT EXISTS record_partition ("
+		"name TEXT NOT NULL PRIMARY KEY, "
+		"file TEXT NOT NULL, "
+		"start_time INTEGER DEFAULT NULL, "
+		"end_time INTEGER DEFAULT NULL"
+		");"
+	);
+	if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(CREATE TABLE)", return false);
+
+	sqlite3_stmt *stmt = NULL;
+	sql				   = "SELECT 1 FROM main.sqlite_master WHERE type = 'table' AND name = 'record';";
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", return false);
+	bool legacy = sqlite3_step(stmt) == SQLITE_ROW;
+	sqlite3_finalize(stmt);
+	if (legacy && !db_partition_split(db))
+		return false;
+
+	sql = "SELECT name FROM record_partition WHERE end_time IS NULL ORDER BY name DESC LIMIT 1;";
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", return false);
+	if (sqlite3_step(stmt) == SQLITE_ROW)
+		strncpy2(partition_name, (const char *)sqlite3_column_text(stmt, 0), sizeof(partition_name) - 1);
+	sqlite3_finalize(stmt);
+	if (partition_name[0] == '\0')
+		db_partition_period(clock_now_ms(), partition_name, sizeof(partition_name));
+
+	if (!db_partition_path(partition_name, partition_path, sizeof(partition_path)) ||
+		!db_partition_attach(db, DB_PARTITION_SCHEMA, partition_name))
+		return false;
+	LT_IM(DB, "record partition %s", partition_path);
+	return true;
+}
+
+/**
+ * Close the current partition and start a new one, if the period changed since it was started.
+ * Must only be called when no trip is in progress, with no statement reading the partition.
+ *
+ * @return whether the partition was rotated (rowids of the new one start from 1)
+ */
+bool db_partition_rotate(sqlite3 *db) {
+	char name[32];
+	db_partition_period(clock_now_ms(), name, sizeof(name));
+	if (strcmp(name, partition_name) == 0)
+		return false;
+	// closed partitions are immutable - keep writing until timestamps can't be re-anchored anymore
+	if (!clock_synced())
+		return false;
+	// records waiting for a trip (or to be re-anchored) are only read from the current partition
+	sqlite3_stmt *stmt = NULL;
+	const char *sql	   = "SELECT 1 FROM " DB_PARTITION_SCHEMA ".record WHERE trip_id IS NULL "
+						 "UNION ALL SELECT 1 FROM main.reanchor LIMIT 1;";
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", return false);
+	bool waiting = sqlite3_step(stmt) == SQLITE_ROW;
+	sqlite3_finalize(stmt);
+	if (waiting)
+		return false;
+
+	LT_IM(DB, "rotating partition %s -> %s", partition_name, name);
+	if (!db_partition_close(db, DB_PARTITION_SCHEMA, partition_name))
+		return false;
+	strcpy(partition_name, name);
+	if (!db_partition_path(partition_name, partition_path, sizeof(partition_path)) ||
+		!db_partition_attach(db, DB_PARTITION_SCHEMA, partition_name))
+		LT_E("Database: cannot attach partition %s, records will not be saved", partition_path);
+	return true;
+}
+
+/**
+ * List all partitions in time order. Must be called after db_partition_open(). The list must be freed by the caller.
+ *
+ * @return number of partitions, or -1 on error
+ */
+int db_partition_list(sqlite3 *db, db_partition_t **list) {
+	int count		   = 0;
+	sqlite3_stmt *stmt = NULL;
+	*list			   = NULL;
+	const char *sql	   = "SELECT name, end_time IS NOT NULL FROM record_partition ORDER BY name;";
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", return -1);
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		void *grown = realloc(*list, (count + 1) * sizeof(**list));
+		if (grown == NULL)
+			LT_ERR(E, goto error, "Database: cannot allocate partition list");
+		*list = grown;
+
+		db_partition_t *part = &(*list)[count++];
+		strncpy2(part->name, (const char *)sqlite3_column_text(stmt, 0), sizeof(part->name) - 1);
+		if (!db_partition_path(part->name, part->path, sizeof(part->path)))
+			goto error;
+		part->closed = sqlite3_column_int(stmt, 1);
+	}
+	sqlite3_finalize(stmt);
+	return count;
+
+error:
+	sqlite3_finalize(stmt);
+	FREE_NULL(*list);
+	return -1;
+}
+
+long long db_partition_size() {
+	struct stat st;
+	if (partition_path[0] == '\0' || stat(partition_path, &st) != 0)
+		return 0;
+	return st.st_size;
+}
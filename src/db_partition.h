@@ -0,0 +1,20 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#pragma once
+
+#include "include.h"
+
+// schema name of the current record partition - unqualified "record" resolves to it, as "main" has no such table
+#define DB_PARTITION_SCHEMA "part"
+
+typedef struct db_partition_t {
+	char name[32];		 //!< Period of the partition
+	char path[PATH_MAX]; //!< Path of the partition file
+	bool closed;		 //!< Whether the partition is closed (read-only), i.e. not the current one
+} db_partition_t;
+
+bool db_partition_create_table(sqlite3 *db, const char *schema);
+bool db_partition_open(sqlite3 *db, const char *filename);
+bool db_partition_rotate(sqlite3 *db);
+int db_partition_list(sqlite3 *db, db_partition_t **list);
+long long db_partition_size();
@@ -0,0 +1,51 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#pragma once
+
+// Columns stored as scaled integers - round(value * scale), read back as value / scale.
+// Also read by web/model/scale.py - keep a single X(column, scale) per line.
+#define DB_SCALES(X)                                                                                                   \
+	X(start_mileage, 10)	  /* 0.1 km */                                                                             \
+	X(end_mileage, 10)		  /* 0.1 km */                                                                             \
+	X(engine_speed, 8)		  /* 0.125 RPM */                                                                          \
+	X(engine_speed_max, 8)	  /* 0.125 RPM */                                                                          \
+	X(vehicle_speed_min, 100) /* 0.01 km/h */                                                                          \
+	X(vehicle_speed_max, 100) /* 0.01 km/h */                                                                          \
+	X(coolant_temp, 100)	  /* 0.01 °C (averages of 1 °C) */                                                         \
+	X(coolant_temp_avg, 100)  /* 0.01 °C */                                                                            \
+	X(coolant_temp_min, 100)  /* 0.01 °C */                                                                            \
+	X(coolant_temp_max, 100)  /* 0.01 °C */                                                                            \
+	X(outside_temp, 100)	  /* 0.01 °C (averages of 0.5 °C) */                                                       \
+	X(outside_temp_avg, 100)  /* 0.01 °C */                                                                            \
+	X(outside_temp_min, 100)  /* 0.01 °C */                                                                            \
+	X(outside_temp_max, 100)  /* 0.01 °C */                                                                            \
+	X(oil_temp, 100)		  /* 0.01 °C (averages of 1 °C) */                                                         \
+	X(oil_temp_avg, 100)	  /* 0.01 °C */                                                                            \
+	X(oil_temp_min, 100)	  /* 0.01 °C */                                                                            \
+	X(oil_temp_max, 100)	  /* 0.01 °C */                                                                            \
+	X(oil_level, 100)		  /* 0.01 % (averages of 1 %) */                                                           \
+	X(oil_level_min, 100)	  /* 0.01 % */                                                                             \
+	X(oil_level_max, 100)	  /* 0.01 % */                                                                             \
+	X(fuel_level, 100)		  /* 0.01 % (averages of 1 %) */                                                           \
+	X(fuel_level_min, 100)	  /* 0.01 % */                                                                             \
+	X(fuel_level_max, 100)	  /* 0.01 % */                                                                             \
+	X(fuel_range, 10)		  /* 0.1 km (averages of 1 km) */                                                          \
+	X(fuel_range_min, 10)	  /* 0.1 km */                                                                             \
+	X(fuel_range_max, 10)	  /* 0.1 km */                                                                             \
+	X(fuel_cons_min, 10)	  /* 0.1 l/100 km */                                                                       \
+	X(fuel_cons_max, 10)	  /* 0.1 l/100 km */                                                                       \
+	X(value, 100)			  /* 0.01 unit of the alert's signal (per minute for rates) */                             \
+	X(threshold, 100)		  /* 0.01 unit of the alert's signal (per minute for rates) */
+
+#define DB_SCALE_ENUM(column, scale) DB_SCALE_##column = scale,
+enum { DB_SCALES(DB_SCALE_ENUM) };
+
+typedef struct db_scale_t {
+	const char *column;
+	int scale;
+} db_scale_t;
+
+// bind/read a scaled column, i.e. db_bind_scaled(stmt, 1, record->start.mileage, start_mileage)
+#define db_bind_scaled(stmt, index, value, column)                                                                     \
+	sqlite3_bind_int64(stmt, index, llround((double)(value) * DB_SCALE_##column))
+#define db_column_scaled(stmt, index, column) (sqlite3_column_int64(stmt, index) / (double)DB_SCALE_##column)
@@ -2,7 +2,53 @@
 
 #include "frames.h"
 
+#define FRAME_METRIC(id) METRIC_COUNTER("triplogger_frames_total", "id=\"" #id "\"", "Decoded CAN frames by ID")
+
+// minimum data length of each supported frame
+static const struct {
+	frame_type_t type;
+	uint8_t length;
+} frame_lengths[] = {
+	{FRAME_BSI_COMMAND, 5},
+	{FRAME_BSI_FAST, 7},
+	{FRAME_BSI_SLOW, 7},
+	{FRAME_TEMP_LEVEL, 7},
+	{FRAME_TRIP_GENERAL, 7},
+	{FRAME_TRIP_DATA_1, 7},
+	{FRAME_TRIP_DATA_2, 7},
+};
+
+// same order as frame_lengths[]
+static metric_t metric_frames[] METRIC_SECTION = {
+	FRAME_METRIC(0x036),
+	FRAME_METRIC(0x0B6),
+	FRAME_METRIC(0x0F6),
+	FRAME_METRIC(0x161),
+	FRAME_METRIC(0x221),
+	FRAME_METRIC(0x2A1),
+	FRAME_METRIC(0x261),
+};
+static metric_t metric_frames_unknown METRIC_SECTION =
+	METRIC_COUNTER("triplogger_frames_unknown_total", NULL, "CAN frames with an unsupported ID");
+static metric_t metric_frame_errors METRIC_SECTION =
+	METRIC_COUNTER("triplogger_frame_errors_total", NULL, "CAN frames too short to decode");
+
 bool frame_parse(struct can_frame *can_frame, frame_t *frame) {
+	unsigned int i;
+	for (i = 0; i < sizeof(frame_lengths) / sizeof(*frame_lengths); i++) {
+		if (frame_lengths[i].type == can_frame->can_id)
+			break;
+	}
+	if (i == sizeof(frame_lengths) / sizeof(*frame_lengths)) {
+		metric_inc(&metric_frames_unknown);
+		return false;
+	}
+	if (can_frame->can_dlc < frame_lengths[i].length) {
+		metric_inc(&metric_frame_errors);
+		return false;
+	}
+	metric_inc(&metric_frames[i]);
+
 	uint8_t *data = can_frame->data;
 	switch (can_frame->can_id) {
 		case FRAME_BSI_COMMAND:
@@ -67,13 +113,79 @@ bool frame_parse(struct can_frame *can_frame, frame_t *frame) {
 	return true;
 }
 
+bool frame_encode(frame_t *frame, struct can_frame *can_frame) {
+	memset(can_frame, 0, sizeof(*can_frame));
+	uint8_t *data = can_frame->data;
+	switch (frame->type) {
+		case FRAME_BSI_COMMAND:
+			data[2] = (frame->bsi_command.economy_mode ? 0x80 : 0) | (frame->bsi_command.power_level & 0b1111);
+			data[4] = frame->bsi_command.network_state & 0b111;
+			break;
+
+		case FRAME_BSI_FAST:
+			data[0] = frame->bsi_fast.engine_speed >> 8;
+			data[1] = frame->bsi_fast.engine_speed >> 0;
+			data[2] = frame->bsi_fast.vehicle_speed >> 8;
+			data[3] = frame->bsi_fast.vehicle_speed >> 0;
+			data[4] = frame->bsi_fast.dist >> 8;
+			data[5] = frame->bsi_fast.dist >> 0;
+			data[6] = frame->bsi_fast.fuel;
+			break;
+
+		case FRAME_BSI_SLOW:
+			data[0] = ((frame->bsi_slow.state_sev & 0b11) << 3) | ((frame->bsi_slow.state_gen & 0b1) << 2) |
+					  ((frame->bsi_slow.state_gmp & 0b11) << 0);
+			data[1] = frame->bsi_slow.coolant_temp + 40;
+			data[2] = frame->bsi_slow.total_mileage >> 16;
+			data[3] = frame->bsi_slow.total_mileage >> 8;
+			data[4] = frame->bsi_slow.total_mileage >> 0;
+			data[6] = frame->bsi_slow.outside_temp + 80;
+			break;
+
+		case FRAME_TEMP_LEVEL:
+			data[2] = frame->temp_level.oil_temp + 40;
+			data[3] = frame->temp_level.fuel_level;
+			data[6] = min(frame->temp_level.oil_level, 0xFFu);
+			break;
+
+		case FRAME_TRIP_GENERAL:
+			data[0] = (frame->trip_general.invalid_cons ? 0x80 : 0) | (frame->trip_general.invalid_range ? 0x40 : 0);
+			data[1] = frame->trip_general.fuel_cons >> 8;
+			data[2] = frame->trip_general.fuel_cons >> 0;
+			data[3] = frame->trip_general.fuel_range >> 8;
+			data[4] = frame->trip_general.fuel_range >> 0;
+			data[5] = frame->trip_general.route_dist >> 8;
+			data[6] = frame->trip_general.route_dist >> 0;
+			break;
+
+		case FRAME_TRIP_DATA_1:
+		case FRAME_TRIP_DATA_2:
+			// both frames have the same layout
+			data[0] = frame->trip_data_1.speed;
+			data[1] = frame->trip_data_1.total_dist >> 8;
+			data[2] = frame->trip_data_1.total_dist >> 0;
+			data[3] = frame->trip_data_1.fuel_cons >> 8;
+			data[4] = frame->trip_data_1.fuel_cons >> 0;
+			data[5] = frame->trip_data_1.total_time >> 8;
+			data[6] = frame->trip_data_1.total_time >> 0;
+			break;
+
+		default:
+			return false;
+	}
+	can_frame->can_id  = frame->type;
+	can_frame->can_dlc = 8;
+	return true;
+}
+
 void frame_print(frame_t *frame) {
 	char buf1[16];
 	char buf2[16];
 
 	switch (frame->type) {
 		case FRAME_BSI_COMMAND:
-			LT_I(
+			LT_IM(
+				FRAME,
 				"BSI_COMMAND - Economy mode: %s, Power level: %u, Network state: %u",
 				frame->bsi_command.economy_mode ? "true" : "false",
 				frame->bsi_command.power_level,
@@ -82,7 +194,8 @@ void frame_print(frame_t *frame) {
 			break;
 
 		case FRAME_BSI_FAST:
-			LT_I(
+			LT_IM(
+				FRAME,
 				"BSI_FAST - Engine: %.3f RPM, Speed: %.2f km/h, Distance: %.1f m, Fuel: %u mm³",
 				frame->bsi_fast.engine_speed * 0.125f,
 				frame->bsi_fast.vehicle_speed * 0.01f,
@@ -92,7 +205,8 @@ void frame_print(frame_t *frame) {
 			break;
 
 		case FRAME_BSI_SLOW:
-			LT_I(
+			LT_IM(
+				FRAME,
 				"BSI_SLOW - Coolant temp.: %d°C, Mileage: %.1f km, Outside temp.: %.1f°C",
 				frame->bsi_slow.coolant_temp,
 				frame->bsi_slow.total_mileage * 0.1f,
@@ -101,7 +215,8 @@ void frame_print(frame_t *frame) {
 			break;
 
 		case FRAME_TEMP_LEVEL:
-			LT_I(
+			LT_IM(
+				FRAME,
 				"TEMP_LEVEL - Oil temp.: %d°C, Fuel level: %u%%, Oil level: %u%%",
 				frame->temp_level.oil_temp,
 				frame->temp_level.fuel_level,
@@ -118,7 +233,8 @@ void frame_print(frame_t *frame) {
 				strcpy(buf2, "(invalid)");
 			else
 				sprintf(buf2, "%u km", frame->trip_general.fuel_range);
-			LT_I(
+			LT_IM(
+				FRAME,
 				"TRIP_GENERAL - Fuel cons.: %s, Remaining distance: %s, Route distance: %.1f",
 				buf1,
 				buf2,
@@ -127,7 +243,8 @@ void frame_print(frame_t *frame) {
 			break;
 
 		case FRAME_TRIP_DATA_1:
-			LT_I(
+			LT_IM(
+				FRAME,
 				"TRIP_DATA_1 - Avg. speed: %u km/h, Distance: %u km, Avg. fuel cons.: %.1f l/100 km, Time: %u min",
 				frame->trip_data_1.speed,
 				frame->trip_data_1.total_dist,
@@ -137,7 +254,8 @@ void frame_print(frame_t *frame) {
 			break;
 
 		case FRAME_TRIP_DATA_2:
-			LT_I(
+			LT_IM(
+				FRAME,
 				"TRIP_DATA_2 - Avg. speed: %u km/h, Distance: %u km, Avg. fuel cons.: %.1f l/100 km, Time: %u min",
 				frame->trip_data_2.speed,
 				frame->trip_data_2.total_dist,
@@ -79,5 +79,20 @@ typedef struct frame_t {
 	};
 } frame_t;
 
+// replay files written by projekt_cangen: a replay_header_t, then replay_frame_t records
+#define REPLAY_MAGIC   0x5052544C // "LTRP"
+#define REPLAY_VERSION 1
+
+typedef struct replay_header_t {
+	uint32_t magic;	  //!< REPLAY_MAGIC
+	uint32_t version; //!< REPLAY_VERSION
+} replay_header_t;
+
+typedef struct replay_frame_t {
+	uint64_t time;				//!< Capture time of the frame (ms since the start of the capture)
+	struct can_frame can_frame; //!< Raw frame
+} replay_frame_t;
+
 bool frame_parse(struct can_frame *can_frame, frame_t *frame);
+bool frame_encode(frame_t *frame, struct can_frame *can_frame);
 void frame_print(frame_t *frame);
@@ -3,9 +3,11 @@
 #pragma once
 
 #include <fcntl.h>
+#include <limits.h>
 #include <math.h>
 #include <pthread.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -17,7 +19,9 @@
 #include <net/if.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/un.h>
 #include <unistd.h>
 
 #if __has_include(<linux/can.h>)
@@ -33,13 +37,20 @@ struct can_frame {
 
 #include <sqlite3.h>
 
+#include "core/clock.h"
 #include "core/config.h"
 #include "core/errmacros.h"
 #include "core/logger.h"
+#include "core/malloc_guard.h"
+#include "core/metrics.h"
 #include "core/utils.h"
 
+#include "alert.h"
+#include "checkpoint.h"
 #include "data/measurement.h"
 #include "data/record.h"
 #include "data/trip.h"
 #include "db.h"
 #include "frames.h"
+#include "live.h"
+#include "power.h"
@@ -0,0 +1,107 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#include "live.h"
+
+_Static_assert(sizeof(((live_alert_packet_t *)0)->rule) == ALERT_NAME_SIZE, "live_alert_packet_t rule size");
+
+static int live_fd					= -1;
+static struct sockaddr_un live_addr = {.sun_family = AF_UNIX};
+static live_packet_t live_packet	= {0};
+static unsigned long long live_last = 0;
+
+int live_open(const char *path) {
+	if (live_fd != -1)
+		return live_fd;
+	// datagrams are sent without blocking - if the web server doesn't read them fast enough
+	// (or isn't running at all), they are simply dropped
+	live_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (live_fd == -1)
+		SOCK_ERROR("socket(AF_UNIX)", return -1);
+	strncpy2(live_addr.sun_path, path, sizeof(live_addr.sun_path) - 1);
+
+	live_packet.magic	= LIVE_MAGIC;
+	live_packet.version = LIVE_VERSION;
+	live_packet.type	= LIVE_TYPE_RECORD;
+
+	LT_IM(LIVE, "publishing to %s", path);
+	return live_fd;
+}
+
+void live_close() {
+	if (live_fd != -1)
+		close(live_fd);
+	live_fd = -1;
+}
+
+void live_frame(frame_t *frame) {
+	switch (frame->type) {
+		case FRAME_BSI_FAST:
+			live_packet.engine_speed  = frame->bsi_fast.engine_speed * 0.125f;
+			live_packet.vehicle_speed = frame->bsi_fast.vehicle_speed * 0.01f;
+			break;
+
+		case FRAME_BSI_SLOW:
+			live_packet.coolant_temp = frame->bsi_slow.coolant_temp;
+			live_packet.outside_temp = frame->bsi_slow.outside_temp * 0.5f;
+			live_packet.mileage		 = frame->bsi_slow.total_mileage * 0.1;
+			break;
+
+		case FRAME_TEMP_LEVEL:
+			live_packet.oil_temp   = frame->temp_level.oil_temp;
+			live_packet.oil_level  = frame->temp_level.oil_level;
+			live_packet.fuel_level = frame->temp_level.fuel_level;
+			break;
+
+		case FRAME_TRIP_GENERAL:
+			if (!frame->trip_general.invalid_cons)
+				live_packet.fuel_cons = frame->trip_general.fuel_cons * 0.1f;
+			if (!frame->trip_general.invalid_range)
+				live_packet.fuel_range = frame->trip_general.fuel_range;
+			break;
+
+		default:
+			break;
+	}
+}
+
+void live_publish(record_t *record) {
+	if (live_fd == -1)
+		return;
+	unsigned long long now = clock_mono_ms();
+	if (now - live_last < LIVE_INTERVAL)
+		return;
+	live_last = now;
+
+	live_packet.seq++;
+	live_packet.time			  = clock_wall_ms(now);
+	live_packet.start_time		  = clock_wall_ms(record->start.time);
+	live_packet.end_time		  = clock_wall_ms(record->end.time);
+	live_packet.dist			  = record->dist;
+	live_packet.fuel			  = record->fuel;
+	live_packet.engine_speed_avg  = record->engine_speed.avg;
+	live_packet.vehicle_speed_avg = record->vehicle_speed.avg;
+	live_packet.fuel_cons_avg	  = record->fuel_cons.avg;
+
+	// errors are ignored on purpose (no listener, receive queue full)
+	sendto(live_fd, &live_packet, sizeof(live_packet), MSG_DONTWAIT, (struct sockaddr *)&live_addr, sizeof(live_addr));
+}
+
+void live_alert(alert_t *alert) {
+	if (live_fd == -1)
+		return;
+	live_alert_packet_t packet = {
+		.magic	 = LIVE_MAGIC,
+		.version = LIVE_VERSION,
+		.type	 = LIVE_TYPE_ALERT,
+		.seq	 = ++live_packet.seq,
+		.time	 = clock_wall_ms(alert->time),
+		.active	 = alert->active,
+		.value	 = (float)alert->value,
+		.limit	 = (float)alert->limit,
+	};
+	memcpy(packet.rule, alert->rule, sizeof(packet.rule));
+	// the rest is zeroed by the initializer - a name filling the whole field is sent without a NUL
+	const char *signal = alert_signal_name(alert->signal);
+	memcpy(packet.signal, signal, strnlen(signal, sizeof(packet.signal)));
+	sendto(live_fd, &packet, sizeof(packet), MSG_DONTWAIT, (struct sockaddr *)&live_addr, sizeof(live_addr));
+}
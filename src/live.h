@@ -0,0 +1,70 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#pragma once
+
+#include "include.h"
+
+typedef struct alert_t alert_t;
+
+#define LIVE_MAGIC	 0x564C544C // "LTLV"
+#define LIVE_VERSION 1
+
+typedef enum {
+	LIVE_TYPE_RECORD = 1, //!< Current record and latest decoded values
+	LIVE_TYPE_ALERT	 = 2, //!< Alert raised or cleared
+} live_type_t;
+
+/**
+ * Live telemetry datagram. All fields are little-endian, without padding.
+ */
+typedef struct __attribute__((packed)) live_packet_t {
+	uint32_t magic;	  //!< LIVE_MAGIC
+	uint16_t version; //!< LIVE_VERSION
+	uint16_t type;	  //!< live_type_t
+	uint32_t seq;	  //!< Packet sequence number
+	uint64_t time;	  //!< Time of sending (ms)
+
+	// current record
+	uint64_t start_time;	 //!< Record start time (ms)
+	uint64_t end_time;		 //!< Record end time (ms)
+	uint32_t dist;			 //!< Record distance (cm)
+	uint32_t fuel;			 //!< Record fuel usage (mm³)
+	float engine_speed_avg;	 //!< Record average engine speed (RPM)
+	float vehicle_speed_avg; //!< Record average vehicle speed (km/h)
+	float fuel_cons_avg;	 //!< Record average fuel consumption (l/100 km)
+
+	// latest decoded values
+	float engine_speed;	 //!< Engine speed (RPM)
+	float vehicle_speed; //!< Vehicle speed (km/h)
+	float coolant_temp;	 //!< Coolant temperature (°C)
+	float outside_temp;	 //!< Outside temperature (°C)
+	float oil_temp;		 //!< Oil temperature (°C)
+	float oil_level;	 //!< Oil level (%)
+	float fuel_level;	 //!< Fuel level (%)
+	float fuel_cons;	 //!< Instant fuel consumption (l/100 km)
+	float fuel_range;	 //!< Approximate remaining range (km)
+	double mileage;		 //!< Total mileage (km)
+} live_packet_t;
+
+/**
+ * Alert datagram, sent right away (not limited by LIVE_INTERVAL). Starts with the same header as live_packet_t.
+ */
+typedef struct __attribute__((packed)) live_alert_packet_t {
+	uint32_t magic;	  //!< LIVE_MAGIC
+	uint16_t version; //!< LIVE_VERSION
+	uint16_t type;	  //!< LIVE_TYPE_ALERT
+	uint32_t seq;	  //!< Packet sequence number
+	uint64_t time;	  //!< Time of sending (ms)
+
+	char rule[32];	 //!< Rule name (NUL-padded)
+	char signal[16]; //!< Signal name (NUL-padded, not terminated if 16 characters long)
+	uint8_t active;	 //!< 1 - raised, 0 - cleared
+	float value;	 //!< Value that raised/cleared the alert (NaN when cleared on shutdown)
+	float limit;	 //!< Limit of the rule
+} live_alert_packet_t;
+
+int live_open(const char *path);
+void live_close();
+void live_frame(frame_t *frame);
+void live_publish(record_t *record);
+void live_alert(alert_t *alert);
@@ -2,14 +2,18 @@
 
 #include "include.h"
 
-int create_can() {
-	int sfd = (int)socket(AF_CAN, SOCK_RAW, CAN_RAW);
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+
+int create_can(const char *interface) {
+	int sfd = (int)socket(AF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
 	if (sfd == -1)
 		SOCK_ERROR("socket()", return -1);
 
-	struct ifreq ifr = {
-		.ifr_name = "can0",
-	};
+	struct ifreq ifr = {0};
+	strncpy2(ifr.ifr_name, interface, sizeof(ifr.ifr_name) - 1);
 	if (ioctl(sfd, SIOCGIFINDEX, &ifr) != 0)
 		SOCK_ERROR("ioctl(SIOCGIFINDEX)", return -1);
 
@@ -23,73 +27,325 @@ int create_can() {
 	return sfd;
 }
 
-int main() {
-	int sfd = -1;
+static bool replay_timed			 = false; //!< Whether the replay input has capture timestamps
+static replay_header_t replay_prefix = {0};	  //!< Start of untimed replay input, read by open_replay()
+static size_t replay_prefix_len		 = 0;
+
+static ssize_t read_full(int fd, void *buf, size_t size, size_t pos) {
+	// files and pipes may return partial frames
+	while (pos < size) {
+		ssize_t ret = read(fd, (uint8_t *)buf + pos, size - pos);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			return ret;
+		if (ret == 0)
+			break;
+		pos += ret;
+	}
+	return (ssize_t)pos;
+}
+
+int open_replay(const char *path) {
+	int fd = STDIN_FILENO;
+	if (strcmp(path, "-") != 0)
+		fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		LT_ERR(F, return -1, "Cannot open replay file %s: %s", path, strerror(errno));
+
+	// timed captures written by the traffic generator start with a header;
+	// otherwise these are raw struct can_frame records, which can only be replayed in real time
+	ssize_t len = read_full(fd, &replay_prefix, sizeof(replay_prefix), 0);
+	if (len == sizeof(replay_prefix) && replay_prefix.magic == REPLAY_MAGIC) {
+		if (replay_prefix.version != REPLAY_VERSION)
+			LT_ERR(F, return -1, "Unsupported replay file version %u", replay_prefix.version);
+		replay_timed = true;
+		return fd;
+	}
+	if (len < 0)
+		LT_ERR(F, return -1, "Cannot read replay file %s: %s", path, strerror(errno));
+	replay_prefix_len = len;
+	LT_WM(MAIN, "replay input has no timestamps, it must be replayed in real time");
+	return fd;
+}
+
+ssize_t read_frame(int fd, struct can_frame *can_frame, bool replay) {
+	if (!replay)
+		return read(fd, can_frame, sizeof(*can_frame));
+
+	if (replay_timed) {
+		replay_frame_t frame;
+		ssize_t len = read_full(fd, &frame, sizeof(frame), 0);
+		if (len != sizeof(frame))
+			return len < 0 ? len : 0;
+		// all timestamps follow the capture, however fast it's replayed
+		clock_replay(frame.time);
+		*can_frame = frame.can_frame;
+		return sizeof(*can_frame);
+	}
+
+	size_t pos = 0;
+	if (replay_prefix_len != 0) {
+		memcpy(can_frame, &replay_prefix, replay_prefix_len);
+		pos				  = replay_prefix_len;
+		replay_prefix_len = 0;
+	}
+	ssize_t len = read_full(fd, can_frame, sizeof(*can_frame), pos);
+	if (len != sizeof(*can_frame))
+		return len < 0 ? len : 0;
+	return len;
+}
+
+static record_t record				 = {0};
+static unsigned int engine_speed	 = 0;
+static unsigned long long last_rx	 = 0;	  //!< Time of the last received frame (clock_mono_ms())
+static bool trip_pending			 = false; //!< Whether the trip may need closing after the bus went idle
+static unsigned long long last_timer = 0;	  //!< Time of the last process_timer() call (clock_mono_ms())
+static int timer_fd					 = -1;	  //!< Main loop timer, runs process_timer()
+
+static int timer_set(unsigned int interval) {
+	struct itimerspec timer = {
+		.it_interval = {interval / 1000, (interval % 1000) * 1000000},
+		.it_value	 = {interval / 1000, (interval % 1000) * 1000000},
+	};
+	return timerfd_settime(timer_fd, 0, &timer, NULL);
+}
+
+static void record_flush() {
+	static unsigned int saved = 0;
+	if (record.start.time != record.end.time && record.dist != 0 && ++saved == MALLOC_GUARD_WARMUP)
+		// the first records went through all lazy initialization - nothing should allocate from now on
+		malloc_guard_arm(true);
+	db_save_record(&record);
+	record_print(&record);
+	record_reset(&record);
+}
+
+static void process_frame(struct can_frame *can_frame) {
+	static int counter = 0;
+	last_rx			   = clock_mono_ms();
+	trip_pending	   = true;
+
+	frame_t frame;
+	if (!frame_parse(can_frame, &frame))
+		return;
+	// frame_print(&frame);
+	if (power_frame(&frame, &record)) {
+		// nothing to do in standby but closing the trip - don't wake up every TIMER_INTERVAL
+		bool standby = power_get() == POWER_STATE_STANDBY;
+		if (timer_set(standby ? STANDBY_TIMER_INTERVAL : TIMER_INTERVAL) != 0)
+			SOCK_ERROR("timerfd_settime()", );
+	}
+	live_frame(&frame);
+
+	if (frame.type == FRAME_BSI_FAST) {
+		if ((bool)engine_speed != (bool)frame.bsi_fast.engine_speed) {
+			// engine starts/stops - save and reset the current record
+			record_flush();
+			// save latest dist/fuel readings
+			unsigned int dist_raw = frame.bsi_fast.dist * 10;
+			unsigned int fuel_raw = frame.bsi_fast.fuel * 80;
+			record.dist_last	  = dist_raw;
+			record.fuel_last	  = fuel_raw;
+		}
+		engine_speed = frame.bsi_fast.engine_speed;
+	}
+
+	// avoid processing records if the engine is not running
+	if (engine_speed == 0)
+		return;
+	// otherwise aggregate frame data into the current record
+	record_append(&record, &frame);
+
+	if ((record.end.time - record.start.time) >= 60 * 1000) {
+		// save and reset records every 1 min
+		record_flush();
+	}
+
+	live_publish(&record);
+
+	if ((counter++ % 10) == 0)
+		record_print(&record);
+}
+
+static void process_timer() {
+	static unsigned long long last_checkpoint = 0;
+	unsigned long long now					  = clock_mono_ms();
+	unsigned long long idle					  = now - last_rx;
+	last_timer								  = now;
+	if (record.start.time != 0 && idle >= BUS_IDLE_TIMEOUT) {
+		// bus went silent without the engine stopping (i.e. ignition off) - don't keep the record in memory
+		LT_IM(MAIN, "no frames for %llu ms, saving record", idle);
+		record_flush();
+		engine_speed = 0;
+	}
+	if (trip_pending && idle >= TRIP_GAP_TIME) {
+		// close the trip now, instead of when the next drive starts
+		db_process_trips();
+		trip_pending = false;
+	}
+
+	if (now - last_checkpoint >= CHECKPOINT_INTERVAL) {
+		checkpoint_save_record(&record);
+		last_checkpoint = now;
+	}
+
+	// shift stored timestamps if NTP stepped the clock after boot
+	long long clock_delta = clock_check();
+	if (clock_delta != 0)
+		db_reanchor(clock_delta);
+}
+
+int main(int argc, char *argv[]) {
+	int ret = 1;
+	int sfd = -1, efd = -1, sigfd = -1;
+	// per-module log levels, i.e. LT_LOG_LEVELS="FRAME=I,*=W"
+	lt_log_configure(getenv("LT_LOG_LEVELS"));
+
+	// handle termination signals in the main loop - blocked before any threads are started
+	sigset_t sigmask;
+	sigemptyset(&sigmask);
+	sigaddset(&sigmask, SIGTERM);
+	sigaddset(&sigmask, SIGINT);
+	sigaddset(&sigmask, SIGHUP);
+	pthread_sigmask(SIG_BLOCK, &sigmask, NULL);
+
+	// read from a CAN interface, or replay frames from a file ("-" for stdin)
+	const char *input = argc > 1 ? argv[1] : CAN_INTERFACE;
+	bool replay		  = if_nametoindex(input) == 0;
+
+	// SQLite gets fixed memory, the record path doesn't allocate at all
+	malloc_guard_thread();
+	db_heap_init();
 	if (db_connect(DATABASE_FILE) == NULL)
 		goto error;
 
+	// continue the trip and save the record interrupted by the last shutdown
+	checkpoint_open(CHECKPOINT_FILE);
+	checkpoint_recover();
 	// process unsaved trips
 	db_process_trips();
+	// checked for every decoded value, from record_append()
+	alert_load(ALERT_RULES_FILE);
 
-	sfd = create_can();
+	sfd = replay ? open_replay(input) : create_can(input);
 	if (sfd == -1)
 		goto error;
-	LT_I("Socket opened");
+	LT_IM(MAIN, "%s opened", replay ? "replay input" : "socket");
+	// only CAN sockets can be filtered in standby
+	power_init(replay ? -1 : sfd);
 
-	record_t record = {0};
-	record_reset(&record);
+	live_open(LIVE_SOCKET);
+	metrics_open(METRICS_SOCKET);
 
-	int counter				  = 0;
-	unsigned int engine_speed = 0;
-	while (1) {
-		struct can_frame can_frame;
-		ssize_t len = read(sfd, &can_frame, sizeof(can_frame));
-		if (len <= 0)
-			return 1;
+	efd = epoll_create1(EPOLL_CLOEXEC);
+	if (efd == -1)
+		SOCK_ERROR("epoll_create1()", goto error);
+	timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (timer_fd == -1)
+		SOCK_ERROR("timerfd_create()", goto error);
+	if (timer_set(TIMER_INTERVAL) != 0)
+		SOCK_ERROR("timerfd_settime()", goto error);
+	sigfd = signalfd(-1, &sigmask, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (sigfd == -1)
+		SOCK_ERROR("signalfd()", goto error);
 
-		frame_t frame;
-		if (!frame_parse(&can_frame, &frame))
-			continue;
-		// frame_print(&frame);
-
-		if (frame.type == FRAME_BSI_FAST) {
-			if ((bool)engine_speed != (bool)frame.bsi_fast.engine_speed) {
-				// engine starts/stops - save and reset the current record
-				db_save_record(&record);
-				record_print(&record);
-				record_reset(&record);
-				// save latest dist/fuel readings
-				unsigned int dist_raw = frame.bsi_fast.dist * 10;
-				unsigned int fuel_raw = frame.bsi_fast.fuel * 80;
-				record.dist_last	  = dist_raw;
-				record.fuel_last	  = fuel_raw;
-			}
-			engine_speed = frame.bsi_fast.engine_speed;
-		}
+	struct epoll_event event = {.events = EPOLLIN};
+	event.data.fd			 = timer_fd;
+	if (epoll_ctl(efd, EPOLL_CTL_ADD, timer_fd, &event) != 0)
+		SOCK_ERROR("epoll_ctl(timerfd)", goto error);
+	event.data.fd = sigfd;
+	if (epoll_ctl(efd, EPOLL_CTL_ADD, sigfd, &event) != 0)
+		SOCK_ERROR("epoll_ctl(signalfd)", goto error);
+	// regular files can't be polled - they are always readable, so they're read between polls instead
+	event.data.fd	= sfd;
+	bool sfd_polled = epoll_ctl(efd, EPOLL_CTL_ADD, sfd, &event) == 0;
+	if (!sfd_polled && errno != EPERM)
+		SOCK_ERROR("epoll_ctl(input)", goto error);
 
-		// avoid processing records if the engine is not running
-		if (engine_speed == 0)
-			continue;
-		// otherwise aggregate frame data into the current record
-		record_append(&record, &frame);
-
-		if ((record.end.time - record.start.time) >= 60 * 1000) {
-			// save and reset records every 1 min
-			db_save_record(&record);
-			record_print(&record);
-			record_reset(&record);
+	record_reset(&record);
+	last_rx	   = clock_mono_ms();
+	last_timer = last_rx;
+
+	bool running = true;
+	while (running) {
+		struct epoll_event events[4];
+		int count = epoll_wait(efd, events, sfd_polled ? 4 : 3, sfd_polled ? -1 : 0);
+		if (count == -1) {
+			if (errno != EINTR)
+				SOCK_ERROR("epoll_wait()", running = false);
+			count = 0;
 		}
+		if (!sfd_polled)
+			events[count++].data.fd = sfd;
 
-		if ((counter++ % 10) == 0)
-			record_print(&record);
+		for (int i = 0; i < count; i++) {
+			int fd = events[i].data.fd;
+			if (fd == timer_fd) {
+				uint64_t expirations;
+				// timed replay runs the timer by the capture time instead (below)
+				if (read(timer_fd, &expirations, sizeof(expirations)) > 0 && !replay_timed)
+					process_timer();
+			} else if (fd == sigfd) {
+				struct signalfd_siginfo info;
+				if (read(sigfd, &info, sizeof(info)) > 0) {
+					LT_IM(MAIN, "received %s, stopping", strsignal((int)info.ssi_signo));
+					ret		= 0;
+					running = false;
+				}
+			} else if (fd == sfd) {
+				// read all queued frames (bounded, so that timers and signals aren't starved);
+				// polled replay input (pipes) blocks until a full frame is read, so only read one
+				int batch = replay && sfd_polled ? 1 : 64;
+				for (int n = 0; n < batch; n++) {
+					struct can_frame can_frame;
+					ssize_t len = read_frame(sfd, &can_frame, replay);
+					if (len == -1 && errno == EAGAIN)
+						break;
+					if (len == 0 && replay) {
+						// end of replay input
+						ret		= 0;
+						running = false;
+						break;
+					}
+					if (len <= 0) {
+						LT_E("Cannot read from %s: %s", input, len == 0 ? "EOF" : strerror(errno));
+						running = false;
+						break;
+					}
+					if (replay_timed && clock_mono_ms() - last_timer >= TIMER_INTERVAL)
+						// before the frame, so that gaps in the capture are seen as an idle bus
+						process_timer();
+					process_frame(&can_frame);
+				}
+			}
+		}
 	}
 
-	db_process_trips();
-
-	return 0;
+	// end raised alerts, save the last record (which also processes trips) and wait for the database
+	alert_clear_all(clock_mono_ms());
+	record_flush();
+	db_wait();
+	checkpoint_save_record(&record);
+	malloc_guard_arm(false);
+	if (MALLOC_GUARD && !malloc_guard_was_armed()) {
+		// too few records to warm up - nothing was checked
+		LT_E("Malloc guard was never armed, %d records with distance are needed", MALLOC_GUARD_WARMUP);
+		ret = 1;
+	}
 
 error:
+	checkpoint_close();
+	metrics_close();
+	live_close();
 	db_close();
-	close(sfd);
-	return 1;
+	if (sigfd != -1)
+		close(sigfd);
+	if (timer_fd != -1)
+		close(timer_fd);
+	if (efd != -1)
+		close(efd);
+	if (sfd != -1)
+		close(sfd);
+	return ret;
 }
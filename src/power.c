@@ -0,0 +1,81 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#include "power.h"
+
+static int power_fd				  = -1;
+static atomic_int power_state	  = POWER_STATE_ACTIVE; //!< power_state_t, also read by database jobs
+static const char *power_names[2] = {"ACTIVE", "STANDBY"};
+
+static metric_t metric_power_state METRIC_SECTION =
+	METRIC_GAUGE("triplogger_power_state", NULL, "Power state (0 - active, 1 - standby)");
+static metric_t metric_power_transitions METRIC_SECTION =
+	METRIC_COUNTER("triplogger_power_transitions_total", NULL, "Power state changes");
+
+static void power_set_filter(bool standby) {
+	if (power_fd == -1)
+		return;
+	// in standby, let the kernel drop everything except BSI_COMMAND - the process only wakes up for these
+	struct can_filter filter = {
+		.can_id	  = standby ? FRAME_BSI_COMMAND : 0,
+		.can_mask = standby ? (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_SFF_MASK) : 0,
+	};
+	if (setsockopt(power_fd, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter)) != 0)
+		LT_WM(POWER, "cannot set CAN filter: %s", strerror(errno));
+}
+
+/**
+ * Set the CAN socket to filter in standby (-1 if frames are not read from a CAN socket).
+ */
+void power_init(int sfd) {
+	power_fd	= sfd;
+	power_state = POWER_STATE_ACTIVE;
+	metric_set(&metric_power_state, power_state);
+}
+
+/**
+ * Update the power state from a BSI_COMMAND frame.
+ *
+ * @param record current record, saved and reset when entering standby
+ * @return whether the state has changed
+ */
+bool power_frame(frame_t *frame, record_t *record) {
+	if (frame->type != FRAME_BSI_COMMAND)
+		return false;
+
+	power_state_t state;
+	switch (frame->bsi_command.network_state) {
+		case NETWORK_STATE_STANDBY:
+		case NETWORK_STATE_COM_OFF:
+			state = POWER_STATE_STANDBY;
+			break;
+		default:
+			state = POWER_STATE_ACTIVE;
+			break;
+	}
+	power_state_t previous = power_get();
+	if (state == previous)
+		return false;
+
+	LT_IM(POWER, "%s -> %s", power_names[previous], power_names[state]);
+	power_state = state;
+	metric_set(&metric_power_state, state);
+	metric_inc(&metric_power_transitions);
+
+	if (state == POWER_STATE_STANDBY) {
+		// write everything out and release memory while parked
+		db_save_record(record);
+		record_reset(record);
+		db_standby();
+		power_set_filter(true);
+		lt_log_flush();
+	} else {
+		// get the database ready before the engine starts
+		power_set_filter(false);
+		db_prewarm();
+	}
+	return true;
+}
+
+power_state_t power_get() {
+	return power_state;
+}
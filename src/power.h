@@ -0,0 +1,14 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#pragma once
+
+#include "include.h"
+
+typedef enum {
+	POWER_STATE_ACTIVE	= 0, //!< CAN network awake, all frames are processed
+	POWER_STATE_STANDBY = 1, //!< CAN network asleep, only waiting for BSI_COMMAND
+} power_state_t;
+
+void power_init(int sfd);
+bool power_frame(frame_t *frame, record_t *record);
+power_state_t power_get();
@@ -0,0 +1,339 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#include "include.h"
+
+#include <getopt.h>
+
+#define SIM_STEP 10 // simulation step (ms)
+
+typedef enum {
+	PROFILE_URBAN,
+	PROFILE_HIGHWAY,
+	PROFILE_IDLE,
+	PROFILE_START_STOP,
+} profile_t;
+
+static const char *profile_names[] = {"urban", "highway", "idle", "startstop"};
+
+/**
+ * Simulated vehicle state, advanced every SIM_STEP.
+ */
+typedef struct sim_t {
+	profile_t profile;
+	unsigned long long time; //!< Simulation time (ms)
+	bool engine;			 //!< Whether the engine is running
+	double speed;			 //!< Vehicle speed (km/h)
+	double engine_speed;	 //!< Engine speed (RPM)
+	double fuel_rate;		 //!< Fuel flow (ml/s)
+	double dist;			 //!< Distance since start (m)
+	double fuel;			 //!< Fuel used since start (ml)
+	double mileage;			 //!< Total mileage (km)
+	double coolant_temp;	 //!< Coolant temperature (°C)
+	double oil_temp;		 //!< Oil temperature (°C)
+	double outside_temp;	 //!< Outside temperature (°C)
+	double fuel_level;		 //!< Fuel level (%)
+	double trip_time;		 //!< Time with the engine running (s)
+} sim_t;
+
+// transmission period of each frame (ms)
+static const struct {
+	frame_type_t type;
+	unsigned int period;
+} frame_periods[] = {
+	{FRAME_BSI_COMMAND, 100},
+	{FRAME_BSI_FAST, 50},
+	{FRAME_BSI_SLOW, 500},
+	{FRAME_TEMP_LEVEL, 1000},
+	{FRAME_TRIP_GENERAL, 1000},
+	{FRAME_TRIP_DATA_1, 1000},
+	{FRAME_TRIP_DATA_2, 1000},
+};
+
+static unsigned long long time_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static double sim_target_speed(sim_t *sim, bool *engine) {
+	double t = sim->time / 1000.0;
+	*engine	 = true;
+	switch (sim->profile) {
+		case PROFILE_URBAN:
+		case PROFILE_START_STOP: {
+			// 90 s cycle: accelerate, cruise, brake, wait at the lights
+			double phase = fmod(t, 90.0);
+			if (phase < 40.0)
+				return 45.0 + 5.0 * sin(t / 7.0);
+			if (phase < 50.0)
+				return 0.0;
+			// the engine stops 5 s after the car stops, and restarts before driving off
+			if (sim->profile == PROFILE_START_STOP && phase > 55.0 && phase < 88.0)
+				*engine = false;
+			return 0.0;
+		}
+		case PROFILE_HIGHWAY:
+			return 120.0 + 10.0 * sin(t / 60.0);
+		case PROFILE_IDLE:
+			return 0.0;
+	}
+	return 0.0;
+}
+
+static void sim_step(sim_t *sim) {
+	double dt = SIM_STEP / 1000.0;
+	bool engine;
+	double target = sim_target_speed(sim, &engine);
+	sim->engine	  = engine;
+
+	// accelerate at 3 km/h/s, brake at 6 km/h/s
+	double accel = 0.0;
+	if (!sim->engine)
+		target = 0.0;
+	if (sim->speed < target)
+		accel = min(3.0, (target - sim->speed) / dt);
+	else if (sim->speed > target)
+		accel = max(-6.0, (target - sim->speed) / dt);
+	sim->speed = max(0.0, sim->speed + accel * dt);
+
+	// a simple 5-speed gearbox
+	static const double ratios[] = {0.0, 110.0, 65.0, 45.0, 35.0, 28.0};
+	if (!sim->engine) {
+		sim->engine_speed = 0.0;
+		sim->fuel_rate	  = 0.0;
+	} else if (sim->speed < 1.0) {
+		sim->engine_speed = 800.0;
+		sim->fuel_rate	  = 0.2;
+	} else {
+		int gear		  = min(5, 1 + (int)(sim->speed / 25.0));
+		sim->engine_speed = max(900.0, sim->speed * ratios[gear]);
+		sim->fuel_rate	  = 0.2 + sim->speed * 0.012 + max(0.0, accel) * 0.3;
+	}
+
+	double dist = sim->speed / 3.6 * dt;
+	sim->dist += dist;
+	sim->mileage += dist / 1000.0;
+	sim->fuel += sim->fuel_rate * dt;
+	sim->fuel_level = max(5.0, 60.0 - sim->fuel / 1000.0 / 50.0 * 100.0);
+
+	// warm up towards the operating temperature, or cool down to the outside temperature
+	double coolant_target = sim->engine ? 90.0 : sim->outside_temp;
+	double oil_target	  = sim->engine ? 100.0 : sim->outside_temp;
+	sim->coolant_temp += (coolant_target - sim->coolant_temp) * dt / 300.0;
+	sim->oil_temp += (oil_target - sim->oil_temp) * dt / 600.0;
+
+	if (sim->engine)
+		sim->trip_time += dt;
+	sim->time += SIM_STEP;
+}
+
+static bool sim_frame(sim_t *sim, frame_type_t type, struct can_frame *can_frame) {
+	frame_t frame = {.type = type};
+	double fuel_cons =
+		sim->speed >= 1.0 ? (sim->fuel_rate * 3.6) / sim->speed * 100.0 : 0.0; // l/100 km
+	double trip_speed = sim->trip_time > 0 ? sim->dist / sim->trip_time * 3.6 : 0.0;
+	double trip_cons  = sim->dist > 0 ? sim->fuel / sim->dist * 100.0 : 0.0;
+
+	switch (type) {
+		case FRAME_BSI_COMMAND:
+			frame.bsi_command.economy_mode	= false;
+			frame.bsi_command.power_level	= sim->engine ? 5 : 1;
+			frame.bsi_command.network_state = NETWORK_STATE_NORMAL;
+			break;
+
+		case FRAME_BSI_FAST:
+			// distance and fuel are wrapping counters
+			frame.bsi_fast.engine_speed	 = (unsigned int)(sim->engine_speed * 8.0);
+			frame.bsi_fast.vehicle_speed = (unsigned int)(sim->speed * 100.0);
+			frame.bsi_fast.dist			 = (unsigned long long)(sim->dist * 10.0) & 0xFFFF;
+			frame.bsi_fast.fuel			 = (unsigned long long)(sim->fuel * 1000.0 / 80.0) & 0xFF;
+			break;
+
+		case FRAME_BSI_SLOW:
+			frame.bsi_slow.state_gen	 = sim->engine;
+			frame.bsi_slow.coolant_temp	 = (int)sim->coolant_temp;
+			frame.bsi_slow.total_mileage = (unsigned int)(sim->mileage * 10.0);
+			frame.bsi_slow.outside_temp	 = (int)(sim->outside_temp * 2.0);
+			break;
+
+		case FRAME_TEMP_LEVEL:
+			frame.temp_level.oil_temp	= (int)sim->oil_temp;
+			frame.temp_level.fuel_level = (unsigned int)sim->fuel_level;
+			frame.temp_level.oil_level	= 80;
+			break;
+
+		case FRAME_TRIP_GENERAL:
+			frame.trip_general.invalid_cons = sim->speed < 1.0;
+			frame.trip_general.fuel_cons	= (unsigned int)min(fuel_cons * 10.0, 999.0);
+			frame.trip_general.fuel_range	= (unsigned int)(sim->fuel_level / 100.0 * 50.0 / 6.0 * 100.0);
+			frame.trip_general.route_dist	= (unsigned int)(sim->dist / 100.0) & 0xFFFF;
+			break;
+
+		case FRAME_TRIP_DATA_1:
+		case FRAME_TRIP_DATA_2:
+			frame.trip_data_1.speed		 = (unsigned int)trip_speed;
+			frame.trip_data_1.total_dist = (unsigned int)(sim->dist / 1000.0);
+			frame.trip_data_1.fuel_cons	 = (unsigned int)min(trip_cons * 10.0, 999.0);
+			frame.trip_data_1.total_time = (unsigned int)(sim->trip_time / 60.0);
+			break;
+	}
+	return frame_encode(&frame, can_frame);
+}
+
+static int open_output(const char *interface, const char *path) {
+	if (interface == NULL) {
+		if (strcmp(path, "-") == 0)
+			return STDOUT_FILENO;
+		int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd == -1)
+			LT_ERR(F, return -1, "Cannot open %s: %s", path, strerror(errno));
+		return fd;
+	}
+
+	int sfd = (int)socket(AF_CAN, SOCK_RAW, CAN_RAW);
+	if (sfd == -1)
+		SOCK_ERROR("socket()", return -1);
+	struct ifreq ifr = {0};
+	strncpy2(ifr.ifr_name, interface, sizeof(ifr.ifr_name) - 1);
+	if (ioctl(sfd, SIOCGIFINDEX, &ifr) != 0)
+		SOCK_ERROR("ioctl(SIOCGIFINDEX)", return -1);
+	struct sockaddr_can addr = {
+		.can_family	 = AF_CAN,
+		.can_ifindex = ifr.ifr_ifindex,
+	};
+	if (bind(sfd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+		SOCK_ERROR("bind()", return -1);
+	return sfd;
+}
+
+static bool write_all(int fd, const void *buf, size_t size) {
+	size_t pos = 0;
+	while (pos < size) {
+		ssize_t ret = write(fd, (const uint8_t *)buf + pos, size - pos);
+		if (ret < 0 && (errno == EINTR || errno == ENOBUFS || errno == EAGAIN)) {
+			// CAN interface queue is full - wait for it to drain
+			if (errno != EINTR)
+				usleep(100);
+			continue;
+		}
+		if (ret <= 0)
+			return false;
+		pos += ret;
+	}
+	return true;
+}
+
+static void usage(const char *name) {
+	fprintf(
+		stderr,
+		"Usage: %s [-p profile] [-s speed] [-d duration] [-i interface | -o file]\n"
+		"  -p profile   urban, highway, idle or startstop (default: urban)\n"
+		"  -s speed     time multiplier, 1 to 1000, 0 = as fast as possible (default: 1)\n"
+		"  -d duration  simulated time in seconds (default: 600)\n"
+		"  -i interface CAN interface to send frames to, i.e. vcan0\n"
+		"  -o file      file to write the capture to (frames with their time), \"-\" for stdout (default)\n",
+		name
+	);
+}
+
+int main(int argc, char *argv[]) {
+	sim_t sim = {
+		.profile	  = PROFILE_URBAN,
+		.mileage	  = 123456.7,
+		.coolant_temp = 15.0,
+		.oil_temp	  = 15.0,
+		.outside_temp = 15.0,
+		.fuel_level	  = 60.0,
+	};
+	double speed		  = 1.0;
+	unsigned int duration = 600;
+	const char *interface = NULL;
+	const char *path	  = "-";
+
+	int opt;
+	while ((opt = getopt(argc, argv, "p:s:d:i:o:h")) != -1) {
+		switch (opt) {
+			case 'p':
+				for (sim.profile = 0; sim.profile < sizeof(profile_names) / sizeof(*profile_names); sim.profile++) {
+					if (strcmp(optarg, profile_names[sim.profile]) == 0)
+						break;
+				}
+				if (sim.profile == sizeof(profile_names) / sizeof(*profile_names)) {
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+			case 's':
+				speed = atof(optarg);
+				break;
+			case 'd':
+				duration = atoi(optarg);
+				break;
+			case 'i':
+				interface = optarg;
+				break;
+			case 'o':
+				path = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (speed < 0.0 || speed > 1000.0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	int fd = open_output(interface, path);
+	if (fd == -1)
+		return 1;
+	// captures are timed, so that the logger can replay them faster than real time
+	replay_header_t header = {
+		.magic	 = REPLAY_MAGIC,
+		.version = REPLAY_VERSION,
+	};
+	if (interface == NULL && !write_all(fd, &header, sizeof(header)))
+		LT_ERR(F, return 1, "Cannot write header: %s", strerror(errno));
+
+	unsigned long long start  = time_ns();
+	unsigned long long frames = 0;
+	while (sim.time < duration * 1000ULL) {
+		sim_step(&sim);
+		for (unsigned int i = 0; i < sizeof(frame_periods) / sizeof(*frame_periods); i++) {
+			if (sim.time % frame_periods[i].period != 0)
+				continue;
+			replay_frame_t frame = {.time = sim.time};
+			if (!sim_frame(&sim, frame_periods[i].type, &frame.can_frame))
+				continue;
+			bool written = interface == NULL ? write_all(fd, &frame, sizeof(frame))
+											 : write_all(fd, &frame.can_frame, sizeof(frame.can_frame));
+			if (!written)
+				LT_ERR(F, return 1, "Cannot write frame: %s", strerror(errno));
+			frames++;
+		}
+
+		if (speed == 0.0)
+			continue;
+		// keep the simulation in sync with the real time, sleeping in 1 ms steps at least
+		long long ahead = (long long)(sim.time * 1000000 / speed) - (long long)(time_ns() - start);
+		if (ahead >= 1000000)
+			usleep(ahead / 1000);
+	}
+
+	double elapsed = (time_ns() - start) / 1e9;
+	fprintf(
+		stderr,
+		"profile=%s frames=%llu sim_s=%llu real_s=%.3f frames_s=%.0f dist_km=%.3f fuel_l=%.3f\n",
+		profile_names[sim.profile],
+		frames,
+		sim.time / 1000,
+		elapsed,
+		frames / elapsed,
+		sim.dist / 1000.0,
+		sim.fuel / 1000.0
+	);
+	if (fd != STDOUT_FILENO)
+		close(fd);
+	return 0;
+}
@@ -0,0 +1,465 @@
+#  Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+"""
+Incremental sync of vehicle databases to a central fleet database.
+
+Usage:
+    fleet_sync.py export -v VEHICLE [-d canlogger.db] [-s STATE] TARGET
+    fleet_sync.py ingest -c fleet.db DIRECTORY
+    fleet_sync.py serve -c fleet.db SOCKET
+
+TARGET is a drop directory (batch files, picked up by "ingest"),
+or unix:PATH of a socket opened by "serve".
+
+Only rows past the high-water mark stored in the STATE file
+(record rowid of each partition, trip ID) are read, so each sync costs
+time proportional to the new data. Records that get assigned to a trip later are updated
+on the central side, when that trip arrives.
+
+Trips rebuilt by retrip are renumbered from 1, so the trip high-water mark
+also keeps a checksum of the trips sent so far. If it doesn't match anymore,
+all trips are sent again, replacing the vehicle's trips on the central side,
+and its records are assigned to the new trips.
+
+Batches are zlib-compressed JSON. The central database keys rows by
+(vehicle_id, start_time, end_time) and upserts them, so applying a batch
+more than once is harmless.
+
+The central database stores scaled columns as integers, like vehicle databases
+since DB_VERSION 2 (see src/db_scale.h). Each batch carries the scales of its
+values, so REAL values of older vehicle databases are converted on ingest.
+"""
+
+import json
+import os
+import socket
+import socketserver
+import sqlite3
+import struct
+import sys
+import re
+import zlib
+from argparse import ArgumentParser
+from pathlib import Path
+
+BATCH_VERSION = 2
+BATCH_ROWS = 5000
+BATCH_SUFFIX = ".batch.z"
+FRAME_LEN = struct.Struct(">I")
+
+# vehicle tables and the column used as their high-water mark
+TABLES = {
+    "record": "rowid",
+    "trip": "trip_id",
+}
+
+# columns stored as round(value * scale), since this PRAGMA user_version
+SCALED_VERSION = 2
+SCALE_HEADER = Path(
+    os.environ.get("DB_SCALE_HEADER", Path(__file__).parents[1] / "src" / "db_scale.h")
+)
+SCALES: dict[str, int] = {
+    column: int(scale)
+    for column, scale in re.findall(r"X\((\w+),\s*(\d+)\)", SCALE_HEADER.read_text())
+}
+
+
+def read_state(path: str) -> dict:
+    try:
+        with open(path) as f:
+            return json.load(f)
+    except FileNotFoundError:
+        return {"seq": 0, "record": {}, "trip": 0, "trip_check": [0, 0, 0]}
+
+
+def write_state(path: str, state: dict) -> None:
+    # replace atomically, so that a crash never loses the high-water mark
+    tmp = f"{path}.tmp"
+    with open(tmp, "w") as f:
+        json.dump(state, f)
+        f.flush()
+        os.fsync(f.fileno())
+    os.replace(tmp, path)
+
+
+def record_partitions(conn: sqlite3.Connection) -> list[tuple[str, str | None]]:
+    # (name, file) of record partitions - older databases have a single record table
+    tables = conn.execute("SELECT name FROM sqlite_master WHERE type = 'table'")
+    if "record_partition" not in {row[0] for row in tables}:
+        return [("main", None)]
+    return conn.execute(
+        "SELECT name, file FROM record_partition ORDER BY name"
+    ).fetchall()
+
+
+def trip_check(conn: sqlite3.Connection, hwm: int) -> list[int]:
+    # count and time sums of the trips sent so far - changed when trips are rebuilt
+    return list(
+        conn.execute(
+            "SELECT count(*), IFNULL(sum(start_time), 0), IFNULL(sum(end_time), 0) "
+            "FROM trip WHERE trip_id <= ?",
+            (hwm,),
+        ).fetchone()
+    )
+
+
+def read_rows(
+    conn: sqlite3.Connection, table: str, key: str, hwm: int, limit: int
+) -> tuple[list[str], list[tuple]]:
+    cursor = conn.execute(
+        f"SELECT {key} AS _hwm, * FROM {table} WHERE {key} > ? ORDER BY {key} LIMIT ?",
+        (hwm, limit),
+    )
+    return [c[0] for c in cursor.description[1:]], cursor.fetchall()
+
+
+def read_batch(
+    conn: sqlite3.Connection, directory: str, vehicle: str, state: dict
+) -> dict | None:
+    # vehicle databases not migrated yet store REAL values
+    (version,) = conn.execute("PRAGMA user_version").fetchone()
+    batch = {
+        "version": BATCH_VERSION,
+        "vehicle": vehicle,
+        "scales": SCALES if version >= SCALED_VERSION else {},
+        "tables": {},
+    }
+    hwm = {**state, "record": dict(state["record"])}
+    for table, key in TABLES.items():
+        if table == "record":
+            # each partition has its own rowids
+            columns, rows = None, []
+            for name, file in record_partitions(conn):
+                if file:
+                    path = os.path.join(directory, file)
+                    conn.execute("ATTACH DATABASE ? AS part", (f"file:{path}?mode=ro",))
+                try:
+                    columns, part_rows = read_rows(
+                        conn,
+                        "part.record" if file else "record",
+                        key,
+                        hwm["record"].get(name, 0),
+                        BATCH_ROWS - len(rows),
+                    )
+                finally:
+                    if file:
+                        conn.execute("DETACH DATABASE part")
+                if part_rows:
+                    hwm["record"][name] = part_rows[-1][0]
+                rows += part_rows
+                if len(rows) >= BATCH_ROWS:
+                    break
+        else:
+            columns, rows = read_rows(conn, table, key, state[table], BATCH_ROWS)
+            if rows:
+                hwm[table] = rows[-1][0]
+                start, end = columns.index("start_time"), columns.index("end_time")
+                hwm["trip_check"] = [
+                    state["trip_check"][0] + len(rows),
+                    state["trip_check"][1] + sum(row[1 + start] for row in rows),
+                    state["trip_check"][2] + sum(row[1 + end] for row in rows),
+                ]
+        if not rows:
+            continue
+        batch["tables"][table] = {
+            "columns": columns,
+            "rows": [row[1:] for row in rows],
+        }
+    if state.get("trip_replace"):
+        # sent even without any trips, so that the old ones are deleted
+        batch["replace"] = ["trip"]
+        del hwm["trip_replace"]
+    elif not batch["tables"]:
+        return None
+    hwm["seq"] = state["seq"] + 1
+    batch["seq"] = hwm["seq"]
+    batch["hwm"] = hwm
+    return batch
+
+
+def encode_batch(batch: dict) -> bytes:
+    return zlib.compress(json.dumps(batch, separators=(",", ":")).encode(), 6)
+
+
+def decode_batch(data: bytes) -> dict:
+    batch = json.loads(zlib.decompress(data))
+    if batch.get("version") not in (1, BATCH_VERSION):
+        raise ValueError(f"Unsupported batch version {batch.get('version')}")
+    # version 1 batches were sent without scales, but their values may be scaled already
+    batch.setdefault("scales", None)
+    return batch
+
+
+def scale_rows(columns: list[str], rows: list[list], scales: dict | None) -> list[list]:
+    # convert values to the scales of the central database; REAL values are not scaled
+    convert = [
+        (i, SCALES[c], (scales or {}).get(c))
+        for i, c in enumerate(columns)
+        if c in SCALES and (scales is None or scales.get(c) != SCALES[c])
+    ]
+    if not convert:
+        return rows
+    rows = [list(row) for row in rows]
+    for row in rows:
+        for i, scale, batch_scale in convert:
+            value = row[i]
+            if value is None or (scales is None and not isinstance(value, float)):
+                continue
+            row[i] = round(value * scale / (batch_scale or 1))
+    return rows
+
+
+def send_file(directory: str, batch: dict, data: bytes) -> None:
+    # written under a temporary name, so "ingest" never reads partial files
+    name = f"{batch['vehicle']}-{batch['seq']:08d}{BATCH_SUFFIX}"
+    tmp = os.path.join(directory, f".{name}.tmp")
+    with open(tmp, "wb") as f:
+        f.write(data)
+        f.flush()
+        os.fsync(f.fileno())
+    os.replace(tmp, os.path.join(directory, name))
+
+
+def send_frame(sock: socket.socket, data: bytes) -> None:
+    sock.sendall(FRAME_LEN.pack(len(data)) + data)
+
+
+def recv_frame(sock: socket.socket) -> bytes | None:
+    header = sock.recv(FRAME_LEN.size, socket.MSG_WAITALL)
+    if len(header) < FRAME_LEN.size:
+        return None
+    (size,) = FRAME_LEN.unpack(header)
+    data = sock.recv(size, socket.MSG_WAITALL)
+    if len(data) < size:
+        raise ConnectionError("Connection closed mid-frame")
+    return data
+
+
+def export(args) -> None:
+    state_path = args.state or f"{args.database}.sync-{args.vehicle}.json"
+    state = read_state(state_path)
+    conn = sqlite3.connect(f"file:{args.database}?mode=ro", uri=True)
+    if isinstance(state["record"], int):
+        # written before records were partitioned - rowids of partitions started later
+        # can't be told apart, so send all records again (they're upserted anyway)
+        state["record"] = {}
+    if trip_check(conn, state["trip"]) != state.get("trip_check"):
+        # trips were rebuilt (or synced before the checksum was kept) - send all of them again
+        state = {**state, "trip": 0, "trip_check": [0, 0, 0], "trip_replace": True}
+
+    sock = None
+    if args.target.startswith("unix:"):
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        sock.connect(args.target[5:])
+
+    batches = rows = size = 0
+    directory = os.path.dirname(args.database)
+    while batch := read_batch(conn, directory, args.vehicle, state):
+        data = encode_batch(batch)
+        if sock:
+            send_frame(sock, data)
+            ack = json.loads(recv_frame(sock) or b"{}")
+            if ack.get("seq") != batch["seq"]:
+                raise ConnectionError(f"Batch {batch['seq']} not acknowledged: {ack}")
+        else:
+            send_file(args.target, batch, data)
+        # only advance the high-water mark once the batch is delivered
+        state = batch["hwm"]
+        write_state(state_path, state)
+        batches += 1
+        rows += sum(len(t["rows"]) for t in batch["tables"].values())
+        size += len(data)
+
+    if sock:
+        sock.close()
+    print(
+        f"vehicle={args.vehicle} batches={batches} rows={rows} bytes={size} "
+        f"record_hwm={json.dumps(state['record'])} trip_hwm={state['trip']}",
+        file=sys.stderr,
+    )
+
+
+class Central:
+    def __init__(self, path: str):
+        self.conn = sqlite3.connect(path, check_same_thread=False)
+        self.conn.execute("PRAGMA journal_mode = WAL")
+        self.conn.executescript(
+            "CREATE TABLE IF NOT EXISTS vehicle ("
+            "vehicle_id TEXT NOT NULL PRIMARY KEY, "
+            "seq INTEGER NOT NULL, "
+            "record_hwm TEXT NOT NULL, "
+            "trip_hwm INTEGER NOT NULL"
+            ");"
+        )
+        self.migrate()
+
+    def migrate(self) -> None:
+        # REAL values synced before the central database was scaled
+        (version,) = self.conn.execute("PRAGMA user_version").fetchone()
+        if version >= SCALED_VERSION:
+            return
+        with self.conn:
+            for table in TABLES:
+                for column in self.columns(table):
+                    if column not in SCALES:
+                        continue
+                    self.conn.execute(
+                        f'UPDATE {table} SET "{column}" = CAST(round("{column}" * ?) AS INTEGER) '
+                        f"WHERE typeof(\"{column}\") = 'real'",
+                        (SCALES[column],),
+                    )
+            self.conn.execute(f"PRAGMA user_version = {SCALED_VERSION}")
+
+    def columns(self, table: str) -> list[str]:
+        return [row[1] for row in self.conn.execute(f"PRAGMA table_info({table})")]
+
+    def ensure_table(self, table: str, columns: list[str]) -> None:
+        # rows are clustered by vehicle - each vehicle's data is a contiguous key range
+        existing = self.columns(table)
+        if not existing:
+            defs = ", ".join(
+                f'"{c}"' for c in columns if c not in ("start_time", "end_time")
+            )
+            self.conn.execute(
+                f"CREATE TABLE {table} ("
+                f"vehicle_id TEXT NOT NULL, start_time INTEGER NOT NULL, end_time INTEGER NOT NULL, {defs}, "
+                f"PRIMARY KEY(vehicle_id, start_time, end_time)"
+                f") WITHOUT ROWID"
+            )
+            if table == "record":
+                self.conn.execute(
+                    "CREATE INDEX record_trip ON record (vehicle_id, trip_id)"
+                )
+            return
+        # columns added to the vehicle schema later
+        for column in columns:
+            if column not in existing:
+                self.conn.execute(f'ALTER TABLE {table} ADD COLUMN "{column}"')
+
+    def apply(self, batch: dict) -> None:
+        vehicle = batch["vehicle"]
+        with self.conn:
+            if "trip" in batch.get("replace", []):
+                # trips were rebuilt - records are assigned again below, as the new trips arrive
+                tables = self.existing_tables()
+                if "trip" in tables:
+                    self.conn.execute(
+                        "DELETE FROM trip WHERE vehicle_id = ?", (vehicle,)
+                    )
+                if "record" in tables:
+                    self.conn.execute(
+                        "UPDATE record SET trip_id = NULL WHERE vehicle_id = ?",
+                        (vehicle,),
+                    )
+            for table, data in batch["tables"].items():
+                if table not in TABLES:
+                    continue
+                columns = data["columns"]
+                self.ensure_table(table, columns)
+                names = ", ".join(f'"{c}"' for c in columns)
+                values = ", ".join("?" for _ in columns)
+                updates = ", ".join(
+                    f'"{c}" = excluded."{c}"'
+                    for c in columns
+                    if c not in ("start_time", "end_time")
+                )
+                self.conn.executemany(
+                    f"INSERT INTO {table} (vehicle_id, {names}) VALUES (?, {values}) "
+                    f"ON CONFLICT (vehicle_id, start_time, end_time) DO UPDATE SET {updates}",
+                    (
+                        [vehicle, *row]
+                        for row in scale_rows(columns, data["rows"], batch["scales"])
+                    ),
+                )
+            trips = batch["tables"].get("trip")
+            if trips and "record" in self.existing_tables():
+                # same assignment as in the logger, for records synced before their trip
+                cols = trips["columns"]
+                idx = (
+                    cols.index("trip_id"),
+                    cols.index("start_time"),
+                    cols.index("end_time"),
+                )
+                self.conn.executemany(
+                    "UPDATE record SET trip_id = ?1 "
+                    "WHERE vehicle_id = ?2 AND start_time >= ?3 AND start_time < ?4 "
+                    "AND end_time > ?3 AND end_time <= ?4 AND trip_id IS NULL",
+                    (
+                        [row[idx[0]], vehicle, row[idx[1]], row[idx[2]]]
+                        for row in trips["rows"]
+                    ),
+                )
+            hwm = batch["hwm"]
+            self.conn.execute(
+                "INSERT OR REPLACE INTO vehicle VALUES (?, ?, ?, ?)",
+                (vehicle, batch["seq"], json.dumps(hwm["record"]), hwm["trip"]),
+            )
+
+    def existing_tables(self) -> set[str]:
+        rows = self.conn.execute("SELECT name FROM sqlite_master WHERE type = 'table'")
+        return {row[0] for row in rows}
+
+
+def ingest(args) -> None:
+    central = Central(args.central)
+    names = sorted(n for n in os.listdir(args.directory) if n.endswith(BATCH_SUFFIX))
+    for name in names:
+        path = os.path.join(args.directory, name)
+        with open(path, "rb") as f:
+            batch = decode_batch(f.read())
+        central.apply(batch)
+        # committed - the batch is not needed anymore
+        os.unlink(path)
+        print(f"applied {name}", file=sys.stderr)
+
+
+def serve(args) -> None:
+    central = Central(args.central)
+
+    class Handler(socketserver.BaseRequestHandler):
+        def handle(self):
+            while data := recv_frame(self.request):
+                batch = decode_batch(data)
+                central.apply(batch)
+                send_frame(self.request, json.dumps({"seq": batch["seq"]}).encode())
+
+    if os.path.exists(args.socket):
+        os.unlink(args.socket)
+    with socketserver.UnixStreamServer(args.socket, Handler) as server:
+        print(f"serving at {args.socket}", file=sys.stderr)
+        server.serve_forever()
+
+
+def main():
+    parser = ArgumentParser(description="Sync vehicle databases to a fleet database")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    parser_export = commands.add_parser(
+        "export", help="Send new rows of a vehicle database"
+    )
+    parser_export.add_argument("target", help="Drop directory, or unix:PATH")
+    parser_export.add_argument("-v", "--vehicle", required=True, help="Vehicle ID")
+    parser_export.add_argument("-d", "--database", default="canlogger.db")
+    parser_export.add_argument("-s", "--state", help="High-water mark file")
+    parser_export.set_defaults(func=export)
+
+    parser_ingest = commands.add_parser(
+        "ingest", help="Apply batch files from a drop directory"
+    )
+    parser_ingest.add_argument("directory")
+    parser_ingest.add_argument("-c", "--central", default="fleet.db")
+    parser_ingest.set_defaults(func=ingest)
+
+    parser_serve = commands.add_parser(
+        "serve", help="Apply batches received on a socket"
+    )
+    parser_serve.add_argument("socket")
+    parser_serve.add_argument("-c", "--central", default="fleet.db")
+    parser_serve.set_defaults(func=serve)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
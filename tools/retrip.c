@@ -0,0 +1,355 @@
+// Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+#include "include.h"
+
+#include <getopt.h>
+
+/**
+ * A record of a partition, with the trip it belongs to.
+ */
+typedef struct retrip_record_t {
+	long long rowid;   //!< Record rowid (in its partition)
+	long long trip_id; //!< Trip ID stored in the database, 0 if NULL
+	size_t trip;	   //!< Index of the trip (in its partition, then in all trips)
+} retrip_record_t;
+
+/**
+ * Trips built from the records of a single partition.
+ */
+typedef struct retrip_part_t {
+	db_partition_t *partition;
+	record_t first;			  //!< First record, to check whether the first trip continues the previous partition
+	retrip_record_t *records; //!< All records, in time order
+	size_t record_count;
+	trip_t *trips; //!< Trips built from the records only
+	size_t trip_count;
+	size_t trip_base; //!< Index of the first trip in all trips
+	bool joined;	  //!< Whether the first trip continues the last trip of the previous partition
+	size_t updated;	  //!< Records with a changed trip ID
+	bool ok;		  //!< Whether the worker succeeded
+} retrip_part_t;
+
+typedef struct retrip_t {
+	retrip_part_t *parts;
+	size_t part_count;
+	atomic_size_t next;		//!< Next partition to process by a worker
+	unsigned long long gap; //!< Minimum gap between trips (ms)
+	trip_t *trips;			//!< All trips, in time order
+	size_t trip_count;
+	long long current; //!< Index of the current (unsaved) trip, or -1
+	bool dry_run;
+} retrip_t;
+
+static unsigned long long time_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static bool retrip_push(void **array, size_t *count, size_t size) {
+	// grow to 64 items first, then by powers of two
+	if (*count != 0 && (*count < 64 || (*count & (*count - 1)) != 0))
+		return true;
+	void *grown = realloc(*array, (*count == 0 ? 64 : *count * 2) * size);
+	if (grown == NULL)
+		return false;
+	*array = grown;
+	return true;
+}
+
+static bool retrip_read(retrip_t *retrip, retrip_part_t *part) {
+	// every worker has its own connection, so that partitions are read in parallel
+	sqlite3 *db		   = NULL;
+	sqlite3_stmt *stmt = NULL;
+	bool ret		   = false;
+	if (sqlite3_open_v2(part->partition->path, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_open_v2()", goto cleanup);
+	const char *sql = "SELECT rowid, IFNULL(trip_id, 0), " DB_RECORD_SELECT " FROM record ORDER BY start_time;";
+	if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+
+	trip_t trip		= {0};
+	record_t record = {0};
+	record_reset(&record);
+	int step;
+	while ((step = sqlite3_step(stmt)) == SQLITE_ROW) {
+		db_column_record(stmt, 2, &record);
+		// the same rule as db_process_trips_thread()
+		if (trip_split(&trip, &record, retrip->gap)) {
+			if (!retrip_push((void **)&part->trips, &part->trip_count, sizeof(*part->trips)))
+				LT_ERR(E, goto cleanup, "Cannot allocate trips");
+			part->trips[part->trip_count++] = trip;
+			trip_reset(&trip);
+		}
+		if (part->record_count == 0)
+			part->first = record;
+		trip_append(&trip, &record);
+
+		if (!retrip_push((void **)&part->records, &part->record_count, sizeof(*part->records)))
+			LT_ERR(E, goto cleanup, "Cannot allocate records");
+		part->records[part->record_count++] = (retrip_record_t){
+			.rowid	 = sqlite3_column_int64(stmt, 0),
+			.trip_id = sqlite3_column_int64(stmt, 1),
+			.trip	 = part->trip_count,
+		};
+	}
+	if (step != SQLITE_DONE)
+		SQLITE3_ERROR("sqlite3_step()", goto cleanup);
+	if (trip.end_time != 0) {
+		if (!retrip_push((void **)&part->trips, &part->trip_count, sizeof(*part->trips)))
+			LT_ERR(E, goto cleanup, "Cannot allocate trips");
+		part->trips[part->trip_count++] = trip;
+	}
+	ret = true;
+
+cleanup:
+	sqlite3_finalize(stmt);
+	sqlite3_close(db);
+	return ret;
+}
+
+static bool retrip_write(retrip_t *retrip, retrip_part_t *part) {
+	sqlite3 *db		   = NULL;
+	sqlite3_stmt *stmt = NULL;
+	bool commit		   = false;
+	// closed partitions are read-only, until their records are rewritten
+	if (part->partition->closed && chmod(part->partition->path, 0644) != 0)
+		LT_ERR(E, return false, "Cannot make %s writable: %s", part->partition->path, strerror(errno));
+	if (sqlite3_open_v2(part->partition->path, &db, SQLITE_OPEN_READWRITE, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_open_v2()", goto cleanup);
+	sqlite3_busy_timeout(db, 5000);
+	if (sqlite3_exec(db, "BEGIN IMMEDIATE;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(BEGIN)", goto cleanup);
+	if (sqlite3_prepare_v2(db, "UPDATE record SET trip_id = ? WHERE rowid = ?;", -1, &stmt, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_prepare_v2()", goto cleanup);
+
+	for (size_t i = 0; i < part->record_count; i++) {
+		retrip_record_t *record = &part->records[i];
+		// records of the current trip are not assigned to any trip yet
+		long long trip_id = (long long)record->trip == retrip->current ? 0 : (long long)record->trip + 1;
+		if (trip_id == record->trip_id)
+			continue;
+		if (trip_id == 0)
+			sqlite3_bind_null(stmt, 1);
+		else
+			sqlite3_bind_int64(stmt, 1, trip_id);
+		sqlite3_bind_int64(stmt, 2, record->rowid);
+		if (sqlite3_step(stmt) != SQLITE_DONE)
+			SQLITE3_ERROR("sqlite3_step()", goto cleanup);
+		sqlite3_reset(stmt);
+		part->updated++;
+	}
+	commit = true;
+
+cleanup:
+	sqlite3_finalize(stmt);
+	if (db != NULL && sqlite3_exec(db, commit ? "COMMIT;" : "ROLLBACK;", NULL, NULL, NULL) != SQLITE_OK)
+		SQLITE3_ERROR("sqlite3_exec(COMMIT)", commit = false);
+	sqlite3_close(db);
+	if (part->partition->closed)
+		chmod(part->partition->path, 0444);
+	return commit;
+}
+
+static void *retrip_read_thread(retrip_t *retrip) {
+	size_t i;
+	while ((i = atomic_fetch_add(&retrip->next, 1)) < retrip->part_count) {
+		retrip->parts[i].ok = retrip_read(retrip, &retrip->parts[i]);
+	}
+	return NULL;
+}
+
+static void *retrip_write_thread(retrip_t *retrip) {
+	size_t i;
+	while ((i = atomic_fetch_add(&retrip->next, 1)) < retrip->part_count) {
+		retrip->parts[i].ok = retrip_write(retrip, &retrip->parts[i]);
+	}
+	return NULL;
+}
+
+static bool retrip_run(retrip_t *retrip, void *(*func)(retrip_t *), int threads) {
+	pthread_t thread[threads];
+	atomic_store(&retrip->next, 0);
+	for (int i = 0; i < threads; i++) {
+		if (pthread_create(&thread[i], NULL, (void *(*)(void *))func, retrip) != 0)
+			LT_ERR(F, return false, "Cannot create thread: %s", strerror(errno));
+	}
+	for (int i = 0; i < threads; i++) {
+		pthread_join(thread[i], NULL);
+	}
+	for (size_t i = 0; i < retrip->part_count; i++) {
+		if (!retrip->parts[i].ok)
+			LT_ERR(E, return false, "Partition %s failed", retrip->parts[i].partition->name);
+	}
+	return true;
+}
+
+static bool retrip_merge(retrip_t *retrip) {
+	// trips of the partitions were built separately - join the ones spanning the partition boundaries,
+	// so that the result is the same as processing all records at once
+	for (size_t i = 0; i < retrip->part_count; i++) {
+		retrip_part_t *part = &retrip->parts[i];
+		size_t first		= 0;
+		part->trip_base		= retrip->trip_count;
+		if (part->trip_count != 0 && retrip->trip_count != 0 &&
+			!trip_split(&retrip->trips[retrip->trip_count - 1], &part->first, retrip->gap)) {
+			trip_merge(&retrip->trips[retrip->trip_count - 1], &part->trips[0]);
+			part->trip_base--;
+			part->joined = true;
+			first		 = 1;
+		}
+		for (; first < part->trip_count; first++) {
+			if (!retrip_push((void **)&retrip->trips, &retrip->trip_count, sizeof(*retrip->trips)))
+				LT_ERR(E, return false, "Cannot allocate trips");
+			retrip->trips[retrip->trip_count++] = part->trips[first];
+		}
+		for (size_t j = 0; j < part->record_count; j++) {
+			part->records[j].trip += part->trip_base;
+		}
+	}
+
+	// the last trip is still in progress if it's recent - the logger continues it from the checkpoint,
+	// but only reads the current partition, so a trip starting in a closed partition is saved as completed
+	retrip->current = -1;
+	if (retrip->part_count == 0 || retrip->trip_count == 0)
+		return true;
+	retrip_part_t *part = &retrip->parts[retrip->part_count - 1];
+	trip_t *trip		= &retrip->trips[retrip->trip_count - 1];
+	if (!part->partition->closed && part->trip_base + part->joined < retrip->trip_count &&
+		(long long)clock_now_ms() - (long long)trip->end_time <= (long long)retrip->gap)
+		retrip->current = (long long)retrip->trip_count - 1;
+	return true;
+}
+
+static void usage(const char *name) {
+	fprintf(
+		stderr,
+		"Usage: %s [-g gap] [-j threads] [-c checkpoint] [-n] [database]\n"
+		"Rebuild all trips from the records. The logger must not be running.\n"
+		"  -g gap        minimum gap between trips in seconds (default: %d)\n"
+		"  -j threads    number of partitions processed in parallel (default: number of CPUs)\n"
+		"  -c checkpoint checkpoint file to update with the current trip (default: %s)\n"
+		"  -n            dry run - only print the summary\n"
+		"  database      database file (default: %s)\n",
+		name,
+		TRIP_GAP_TIME / 1000,
+		CHECKPOINT_FILE,
+		DATABASE_FILE
+	);
+}
+
+int main(int argc, char *argv[]) {
+	retrip_t retrip = {
+		.gap = TRIP_GAP_TIME,
+	};
+	int threads				   = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	const char *checkpoint	   = CHECKPOINT_FILE;
+	const char *path		   = DATABASE_FILE;
+	db_partition_t *partitions = NULL;
+	int ret					   = 1;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "g:j:c:nh")) != -1) {
+		switch (opt) {
+			case 'g':
+				retrip.gap = strtoull(optarg, NULL, 10) * 1000;
+				break;
+			case 'j':
+				threads = atoi(optarg);
+				break;
+			case 'c':
+				checkpoint = optarg;
+				break;
+			case 'n':
+				retrip.dry_run = true;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (optind < argc)
+		path = argv[optind];
+	if (retrip.gap == 0 || threads < 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	sqlite3 *db = db_connect(path);
+	if (db == NULL)
+		return 1;
+	int count = db_partition_list(db, &partitions);
+	if (count < 0)
+		goto cleanup;
+	retrip.part_count = count;
+	retrip.parts	  = calloc(count, sizeof(*retrip.parts));
+	if (count != 0 && retrip.parts == NULL)
+		LT_ERR(F, goto cleanup, "Cannot allocate partitions");
+	for (int i = 0; i < count; i++) {
+		retrip.parts[i].partition = &partitions[i];
+	}
+	threads = min(threads, max(count, 1));
+
+	// read all partitions in parallel, then join their trips
+	unsigned long long start = time_ns();
+	if (!retrip_run(&retrip, retrip_read_thread, threads) || !retrip_merge(&retrip))
+		goto cleanup;
+	double read_s = (time_ns() - start) / 1e9;
+
+	// records are rewritten first - if interrupted, running again finishes the job
+	start = time_ns();
+	if (!retrip.dry_run) {
+		if (!retrip_run(&retrip, retrip_write_thread, threads))
+			goto cleanup;
+		trip_t *current = retrip.current < 0 ? NULL : &retrip.trips[retrip.current];
+		size_t saved	= retrip.trip_count - (current != NULL);
+		if (!db_replace_trips(retrip.trips, saved, current))
+			goto cleanup;
+
+		// the logger continues the current trip after the last record of the current partition
+		long long rowid = 0;
+		if (count != 0 && !partitions[count - 1].closed) {
+			retrip_part_t *part = &retrip.parts[count - 1];
+			for (size_t i = 0; i < part->record_count; i++) {
+				rowid = max(rowid, part->records[i].rowid);
+			}
+		}
+		trip_t empty = {0};
+		if (checkpoint_open(checkpoint)) {
+			checkpoint_save_trip(current != NULL ? current : &empty, rowid);
+			checkpoint_close();
+		}
+	}
+	double write_s = (time_ns() - start) / 1e9;
+
+	size_t records = 0, updated = 0;
+	for (size_t i = 0; i < retrip.part_count; i++) {
+		records += retrip.parts[i].record_count;
+		updated += retrip.parts[i].updated;
+	}
+	fprintf(
+		stderr,
+		"partitions=%zu records=%zu trips=%zu current=%s updated=%zu threads=%d read_s=%.3f write_s=%.3f%s\n",
+		retrip.part_count,
+		records,
+		retrip.trip_count - (retrip.current >= 0),
+		retrip.current >= 0 ? "yes" : "no",
+		updated,
+		threads,
+		read_s,
+		write_s,
+		retrip.dry_run ? " (dry run)" : ""
+	);
+	ret = 0;
+
+cleanup:
+	for (size_t i = 0; i < retrip.part_count; i++) {
+		free(retrip.parts[i].records);
+		free(retrip.parts[i].trips);
+	}
+	free(retrip.parts);
+	free(retrip.trips);
+	free(partitions);
+	db_close();
+	return ret;
+}
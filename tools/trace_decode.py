@@ -0,0 +1,204 @@
+#  Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+"""Decode a binary trace file written with LT_LOGGER_TRACE enabled."""
+
+import re
+import struct
+import sys
+from argparse import ArgumentParser
+from dataclasses import dataclass
+from datetime import datetime
+
+HEADER = struct.Struct("<4sIIIIIIIQ24x")
+DICT_ENTRY = struct.Struct("<HBBHH")
+ENTRY = struct.Struct("<HHIQ")
+ENTRY_MAGIC = 0x4C54
+STR_NULL = 0xFFFF
+
+LEVELS = "VDIWEF"
+ARG_STRUCTS = {
+    "i": struct.Struct("<i"),
+    "P": struct.Struct("<i"),
+    "l": struct.Struct("<q"),
+    "d": struct.Struct("<d"),
+    "D": struct.Struct("<d"),
+    "p": struct.Struct("<Q"),
+}
+STR_LEN = struct.Struct("<H")
+
+# a single printf() conversion: flags, width, precision, length, conversion
+SPEC = re.compile(
+    r"%([-+ #0']*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|q|j|z|t|L)?([diouxXcfFeEgGaAspn%])"
+)
+UNSIGNED_BITS = {"hh": 8, "h": 16}
+
+
+@dataclass
+class Site:
+    level: int
+    caller: str
+    line: int
+    format: str
+    types: str
+
+
+def read_sites(data: bytes, offset: int, count: int) -> list[Site]:
+    sites = []
+    for _ in range(count):
+        line, level, argc, caller_len, format_len = DICT_ENTRY.unpack_from(
+            data, offset
+        )
+        offset += DICT_ENTRY.size
+        caller = data[offset : offset + caller_len].decode(errors="replace")
+        offset += caller_len
+        fmt = data[offset : offset + format_len].decode(errors="replace")
+        offset += format_len
+        types = data[offset : offset + argc].decode()
+        offset += argc
+        sites.append(Site(level, caller, line, fmt, types))
+    return sites
+
+
+def read_args(types: str, data: bytes, offset: int) -> list:
+    args = []
+    for arg_type in types:
+        if arg_type == "s":
+            (length,) = STR_LEN.unpack_from(data, offset)
+            offset += STR_LEN.size
+            if length == STR_NULL:
+                args.append(None)
+                continue
+            args.append(data[offset : offset + length].decode(errors="replace"))
+            offset += length
+            continue
+        arg_struct = ARG_STRUCTS[arg_type]
+        args.append(arg_struct.unpack_from(data, offset)[0])
+        offset += arg_struct.size
+    return args
+
+
+def format_message(site: Site, args: list) -> str:
+    args = iter(zip(site.types, args))
+
+    def convert(match: re.Match) -> str:
+        flags, width, precision, length, conv = match.groups()
+        if conv == "%":
+            return "%"
+        spec_args = []
+        if width == "*":
+            spec_args.append(next(args)[1])
+        if precision == "*":
+            spec_args.append(next(args)[1])
+        try:
+            arg_type, value = next(args)
+        except StopIteration:
+            return match.group(0)
+        flags = flags.replace("'", "")
+        spec = "%" + flags + (width or "")
+        if precision is not None:
+            spec += "." + precision
+        if conv in "uoxX":
+            bits = UNSIGNED_BITS.get(length, 64 if arg_type == "l" else 32)
+            value &= (1 << bits) - 1
+            conv = "d" if conv == "u" else conv
+        elif conv == "p":
+            return "0x%x" % value
+        elif conv == "n":
+            return ""
+        elif conv in "aA":
+            value = float.hex(value)
+            conv = "s"
+        elif conv == "s" and value is None:
+            value = "(null)"
+        return (spec + conv) % (*spec_args, value)
+
+    return SPEC.sub(convert, site.format)
+
+
+def read_entries(ring: bytes, write_pos: int, sites: list[Site]):
+    ring_size = len(ring)
+    if write_pos <= ring_size:
+        data = ring[:write_pos]
+        wrapped = False
+    else:
+        start = write_pos % ring_size
+        data = ring[start:] + ring[:start]
+        wrapped = True
+
+    offset = 0
+    synced = not wrapped
+    while offset + ENTRY.size <= len(data):
+        magic, site_id, size, time = ENTRY.unpack_from(data, offset)
+        valid = (
+            magic == ENTRY_MAGIC
+            and site_id < len(sites)
+            and size >= ENTRY.size
+            and size % 8 == 0
+            and offset + size <= len(data)
+        )
+        if not valid:
+            if synced:
+                # entry being written or lost - nothing more to read
+                break
+            # the oldest entry was overwritten - find the next one
+            offset += 8
+            continue
+        synced = True
+        site = sites[site_id]
+        try:
+            args = read_args(site.types, data, offset + ENTRY.size)
+        except (struct.error, UnicodeDecodeError):
+            args = None
+        yield time, site, args
+        offset += size
+
+
+def main():
+    parser = ArgumentParser(description="Decode a binary trace file")
+    parser.add_argument("file", nargs="?", default="canlogger.trace")
+    parser.add_argument("-l", "--level", default="V", choices=list(LEVELS))
+    parser.add_argument("--sites", action="store_true", help="list log sites only")
+    args = parser.parse_args()
+
+    with open(args.file, "rb") as f:
+        data = f.read()
+
+    (
+        magic,
+        version,
+        site_count,
+        dict_offset,
+        dict_size,
+        ring_offset,
+        ring_size,
+        _,
+        write_pos,
+    ) = HEADER.unpack_from(data)
+    if magic != b"LTTR" or version != 1:
+        print(f"{args.file}: not a trace file", file=sys.stderr)
+        exit(1)
+    sites = read_sites(data, dict_offset, site_count)
+
+    if args.sites:
+        for i, site in enumerate(sites):
+            print(f"{i:5d} {LEVELS[site.level]} {site.caller}():{site.line}: {site.format!r}")
+        return
+
+    min_level = LEVELS.index(args.level)
+    ring = data[ring_offset : ring_offset + ring_size]
+    for time, site, values in read_entries(ring, write_pos, sites):
+        if site.level < min_level:
+            continue
+        if values is None:
+            message = f"<invalid arguments> {site.format}"
+        else:
+            message = format_message(site, values)
+        timestamp = datetime.fromtimestamp(time / 1e6).strftime("%Y-%m-%d %H:%M:%S")
+        print(
+            f"{LEVELS[site.level]} [{timestamp}.{time // 1000 % 1000:03d}] "
+            f"{site.caller}():{site.line}: {message}"
+        )
+
+
+if __name__ == "__main__":
+    main()
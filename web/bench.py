@@ -0,0 +1,80 @@
+#  Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+"""
+Concurrency benchmark of the API server.
+
+Usage: python -m web.bench [URL] [REQUESTS]
+
+For increasing numbers of concurrent clients, sends REQUESTS requests
+and prints one line of latency percentiles (in milliseconds) per level:
+
+    clients=<n> requests=<n> rps=<n> p50=<ms> p90=<ms> p99=<ms> max=<ms>
+
+List endpoints answer repeated requests from the response cache, without
+querying the database - use an uncached one (i.e. /api/trips/<id>) to
+measure the query pool.
+"""
+
+import asyncio
+import sys
+import time
+from urllib.parse import urlsplit
+
+CLIENTS = (1, 2, 4, 8, 16, 32, 64)
+
+
+async def request(host: str, port: int, path: str) -> float:
+    start = time.perf_counter()
+    reader, writer = await asyncio.open_connection(host, port)
+    writer.write(
+        f"GET {path} HTTP/1.1\r\nHost: {host}\r\nConnection: close\r\n\r\n".encode()
+    )
+    await writer.drain()
+    status = await reader.readline()
+    if status.split(b" ")[1:2] != [b"200"]:
+        raise RuntimeError(f"Request failed: {status.decode().strip()}")
+    await reader.read()
+    writer.close()
+    return time.perf_counter() - start
+
+
+async def run_level(url: str, clients: int, count: int) -> list[float]:
+    parts = urlsplit(url)
+    path = parts.path + (f"?{parts.query}" if parts.query else "")
+    latencies = []
+    remaining = count
+
+    async def client():
+        nonlocal remaining
+        while remaining > 0:
+            remaining -= 1
+            latencies.append(await request(parts.hostname, parts.port or 80, path))
+
+    await asyncio.gather(*(client() for _ in range(clients)))
+    return latencies
+
+
+def percentile(values: list[float], p: float) -> float:
+    return values[min(int(len(values) * p), len(values) - 1)] * 1000.0
+
+
+async def main():
+    url = sys.argv[1] if len(sys.argv) > 1 else "http://127.0.0.1:8000/api/trips"
+    count = int(sys.argv[2]) if len(sys.argv) > 2 else 500
+    for clients in CLIENTS:
+        start = time.perf_counter()
+        latencies = sorted(await run_level(url, clients, count))
+        elapsed = time.perf_counter() - start
+        print(
+            f"clients={clients} requests={len(latencies)} "
+            f"rps={len(latencies) / elapsed:.0f} "
+            f"p50={percentile(latencies, 0.50):.2f} "
+            f"p90={percentile(latencies, 0.90):.2f} "
+            f"p99={percentile(latencies, 0.99):.2f} "
+            f"max={latencies[-1] * 1000.0:.2f}",
+            flush=True,
+        )
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,91 @@
+#  Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+import json
+import time
+from collections import OrderedDict
+from hashlib import sha1
+from threading import Lock
+from typing import Any, Callable
+
+from fastapi import Request, Response
+from fastapi.encoders import jsonable_encoder
+from sqlmodel import Session
+
+from .db import open_readonly, run_db, run_session
+
+
+class DataVersion:
+    """
+    Tracks changes made to the database by other connections (i.e. the logger),
+    using PRAGMA data_version of a dedicated connection. No tables are read.
+    Only the main database is checked - records are saved to partitions, but
+    processing each of them also updates trip_current.
+    """
+
+    def __init__(self):
+        self.conn = open_readonly()
+        self.lock = Lock()
+        # data_version values are only meaningful within one connection
+        self.nonce = f"{int(time.time() * 1000):x}"
+
+    def get(self) -> str:
+        with self.lock:
+            (version,) = self.conn.execute("PRAGMA data_version").fetchone()
+        return f"{self.nonce}-{version}"
+
+
+class ResponseCache:
+    """
+    In-process cache of serialized JSON responses, keyed by endpoint and query
+    parameters (i.e. the pagination cursor). Entries are valid for as long as
+    the database version doesn't change.
+    """
+
+    def __init__(self, data_version: DataVersion, max_entries: int = 256):
+        self.data_version = data_version
+        self.max_entries = max_entries
+        self.entries: OrderedDict[tuple, tuple[str, bytes, dict]] = OrderedDict()
+        self.lock = Lock()
+
+    async def respond(
+        self,
+        request: Request,
+        key: tuple,
+        producer: Callable[[Session], tuple[Any, dict]],
+        media_type: str = "application/json",
+    ) -> Response:
+        version = await run_db(self.data_version.get)
+        digest = sha1(repr(key).encode()).hexdigest()[:16]
+        etag = f'"{version}-{digest}"'
+        if etag in request.headers.get("if-none-match", "").split(", "):
+            return Response(status_code=304, headers=self.headers(etag))
+
+        with self.lock:
+            entry = self.entries.get(key)
+            if entry and entry[0] == etag:
+                self.entries.move_to_end(key)
+        if not entry or entry[0] != etag:
+            data, headers = await run_session(producer)
+            if isinstance(data, bytes):
+                body = data
+            else:
+                body = json.dumps(jsonable_encoder(data), separators=(",", ":"))
+                body = body.encode()
+            entry = (etag, body, headers)
+            with self.lock:
+                self.entries[key] = entry
+                self.entries.move_to_end(key)
+                while len(self.entries) > self.max_entries:
+                    self.entries.popitem(last=False)
+
+        _, body, headers = entry
+        return Response(
+            content=body,
+            media_type=media_type,
+            headers={**self.headers(etag), **headers},
+        )
+
+    @staticmethod
+    def headers(etag: str) -> dict:
+        # let browsers store the response, but always revalidate it
+        return {"ETag": etag, "Cache-Control": "no-cache", "Vary": "Accept"}
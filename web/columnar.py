@@ -0,0 +1,76 @@
+#  Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+"""
+Packed columnar response format, decoded into TypedArrays by the frontend.
+
+All numbers are little-endian. Layout:
+
+    char     magic[4]        "TLC1"
+    uint32   row_count
+    uint32   column_count
+    column_count times:
+        char     type         'd' - float64, 'i' - int32
+        uint8    name_length
+        char     name[name_length]
+    padding to a multiple of 8 bytes
+    column_count times:
+        type     values[row_count]
+        padding to a multiple of 8 bytes
+
+NULL values are encoded as NaN (float64 columns only).
+"""
+
+import struct
+import sys
+from array import array
+from typing import Sequence
+
+from fastapi import Request
+
+COLUMNAR_MAGIC = b"TLC1"
+COLUMNAR_MEDIA_TYPE = "application/vnd.triplogger.columnar"
+COLUMNAR_TYPES = ("d", "i")
+
+
+def wants_columnar(request: Request) -> bool:
+    return COLUMNAR_MEDIA_TYPE in request.headers.get("accept", "")
+
+
+def pad8(data: bytearray) -> bytearray:
+    data += bytes(-len(data) % 8)
+    return data
+
+
+def encode_columnar(
+    columns: Sequence[tuple[str, str]],
+    values: Sequence[Sequence],
+) -> bytes:
+    """
+    Encode `values` (one sequence per column) as columns of the given (name, type).
+    """
+    row_count = len(values[0]) if values else 0
+    data = bytearray(COLUMNAR_MAGIC)
+    data += struct.pack("<II", row_count, len(columns))
+    for name, type_code in columns:
+        if type_code not in COLUMNAR_TYPES:
+            raise ValueError(f"Unsupported column type: {type_code}")
+        encoded = name.encode()
+        data += struct.pack("<cB", type_code.encode(), len(encoded)) + encoded
+    pad8(data)
+
+    for (_, type_code), column in zip(columns, values):
+        if type_code == "d":
+            column = array("d", (v if v is not None else float("nan") for v in column))
+        else:
+            column = array("i", column)
+        if sys.byteorder != "little":
+            column.byteswap()
+        data += column.tobytes()
+        pad8(data)
+    return bytes(data)
+
+
+def rows_to_columns(rows: Sequence[tuple], column_count: int) -> list[Sequence]:
+    if not rows:
+        return [()] * column_count
+    return list(zip(*rows))
@@ -0,0 +1,62 @@
+#  Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+import asyncio
+import os
+import sqlite3
+from concurrent.futures import ThreadPoolExecutor
+from functools import partial
+from typing import Callable, TypeVar
+
+from sqlalchemy.pool import QueuePool
+from sqlmodel import Session, create_engine
+
+T = TypeVar("T")
+
+sqlite_file_name = os.environ.get("DATABASE_FILE", "canlogger.db")
+# number of worker threads (and pooled connections) used for queries
+db_workers = int(os.environ.get("DB_WORKERS", "4"))
+db_mmap_size = int(os.environ.get("DB_MMAP_SIZE", str(256 * 1024 * 1024)))
+
+
+def open_readonly() -> sqlite3.Connection:
+    # the logger is the only writer; it keeps the database in WAL mode,
+    # so readers never block it (nor each other)
+    conn = sqlite3.connect(
+        f"file:{sqlite_file_name}?mode=ro",
+        uri=True,
+        check_same_thread=False,
+    )
+    conn.execute("PRAGMA query_only = 1")
+    conn.execute(f"PRAGMA mmap_size = {db_mmap_size}")
+    return conn
+
+
+engine = create_engine(
+    "sqlite://",
+    creator=open_readonly,
+    poolclass=QueuePool,
+    pool_size=db_workers,
+    max_overflow=0,
+)
+db_executor = ThreadPoolExecutor(max_workers=db_workers, thread_name_prefix="db")
+
+
+async def run_db(func: Callable[..., T], *args) -> T:
+    """
+    Run a blocking function in the database thread pool.
+    """
+    loop = asyncio.get_running_loop()
+    return await loop.run_in_executor(db_executor, partial(func, *args))
+
+
+async def run_session(func: Callable[[Session], T]) -> T:
+    """
+    Run a blocking function with a pooled read-only session,
+    without blocking the event loop.
+    """
+
+    def run() -> T:
+        with Session(engine) as session:
+            return func(session)
+
+    return await run_db(run)
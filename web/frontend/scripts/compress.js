@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) Kuba Szczodrzyński 2026-10-19.
+ */
+
+// Precompress the production build with brotli and gzip,
+// so that the server doesn't need to compress anything at runtime.
+
+const fs = require("fs")
+const path = require("path")
+const zlib = require("zlib")
+
+const BUILD_DIR = path.join(__dirname, "..", "build")
+const EXTENSIONS = [".html", ".js", ".css", ".json", ".svg", ".txt", ".map"]
+const MIN_SIZE = 1024
+
+function* walk(dir) {
+	for (const entry of fs.readdirSync(dir, { withFileTypes: true })) {
+		const file = path.join(dir, entry.name)
+		if (entry.isDirectory()) yield* walk(file)
+		else yield file
+	}
+}
+
+let count = 0
+for (const file of walk(BUILD_DIR)) {
+	if (!EXTENSIONS.includes(path.extname(file))) continue
+	const data = fs.readFileSync(file)
+	if (data.length < MIN_SIZE) continue
+	const br = zlib.brotliCompressSync(data, {
+		params: {
+			[zlib.constants.BROTLI_PARAM_QUALITY]:
+				zlib.constants.BROTLI_MAX_QUALITY,
+			[zlib.constants.BROTLI_PARAM_SIZE_HINT]: data.length,
+		},
+	})
+	const gz = zlib.gzipSync(data, { level: zlib.constants.Z_BEST_COMPRESSION })
+	// only keep the variants that are actually smaller
+	if (br.length < data.length) fs.writeFileSync(file + ".br", br)
+	if (gz.length < data.length) fs.writeFileSync(file + ".gz", gz)
+	count++
+}
+console.log(`Compressed ${count} files in ${BUILD_DIR}`)
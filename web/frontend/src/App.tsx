@@ -19,6 +19,7 @@ import {
 import NavbarToggle from "react-bootstrap/NavbarToggle"
 import NavbarCollapse from "react-bootstrap/NavbarCollapse"
 import TripPage from "./pages/TripPage"
+import StatsPage from "./pages/StatsPage"
 
 const App: React.FC = () => (
 	<BrowserRouter>
@@ -56,6 +57,9 @@ const App: React.FC = () => (
 						<TripPage tripId={parseInt(props.match.params.id)} />
 					)}
 				></Route>
+				<Route exact path="/stats">
+					<StatsPage />
+				</Route>
 			</Switch>
 		</Container>
 	</BrowserRouter>
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Kuba Szczodrzyński 2026-10-19.
+ */
+
+import React from "react"
+import StatCard from "./StatCard"
+
+type LivePacket = {
+	time: number
+	engine_speed: number
+	vehicle_speed: number
+	coolant_temp: number
+	outside_temp: number
+	fuel_level: number
+	fuel_cons: number
+	fuel_range: number
+}
+
+type LiveStatsState = {
+	packet?: LivePacket
+}
+
+export default class LiveStats extends React.Component<any, LiveStatsState> {
+	source?: EventSource
+
+	constructor(props: any) {
+		super(props)
+		this.state = {}
+	}
+
+	componentDidMount() {
+		this.source = new EventSource("/api/live")
+		this.source.onmessage = (event) =>
+			this.setState({ packet: JSON.parse(event.data) })
+	}
+
+	componentWillUnmount() {
+		this.source?.close()
+	}
+
+	render() {
+		const packet = this.state.packet
+		// hide when the logger is not sending anything
+		if (!packet || Date.now() - packet.time > 10 * 1000) return null
+		return (
+			<div>
+				<h2 className="mt-3 mb-0">Na żywo</h2>
+				<div className="mt-3">
+					<StatCard
+						title="Prędkość"
+						value={packet.vehicle_speed.toFixed(0) + " km/h"}
+					/>
+					<StatCard
+						title="Obroty"
+						value={packet.engine_speed.toFixed(0) + " RPM"}
+					/>
+					<StatCard
+						title="Spalanie"
+						value={packet.fuel_cons.toFixed(1) + " l/100 km"}
+					/>
+					<StatCard
+						title="Paliwo"
+						value={packet.fuel_level.toFixed(0) + "%"}
+					/>
+					<StatCard
+						title="Zasięg"
+						value={packet.fuel_range.toFixed(0) + " km"}
+					/>
+					<StatCard
+						title="Temp. silnika"
+						value={packet.coolant_temp.toFixed(0) + "°C"}
+					/>
+				</div>
+			</div>
+		)
+	}
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Kuba Szczodrzyński 2026-10-19.
+ */
+
+import React from "react"
+import { Table } from "react-bootstrap"
+
+type VirtualTableProps = {
+	header: React.ReactNode
+	rowCount: number
+	rowHeight: number // px
+	height: number // px
+	overscan?: number // rows rendered outside of the viewport
+	renderRow: (index: number) => React.ReactNode
+	onEndReached?: () => void
+}
+
+type VirtualTableState = {
+	scrollTop: number
+}
+
+/**
+ * A table rendering only the rows that are currently visible.
+ * All rows must have the same height.
+ */
+export default class VirtualTable extends React.Component<
+	VirtualTableProps,
+	VirtualTableState
+> {
+	frame?: number
+
+	constructor(props: VirtualTableProps) {
+		super(props)
+		this.state = { scrollTop: 0 }
+	}
+
+	componentWillUnmount() {
+		if (this.frame) cancelAnimationFrame(this.frame)
+	}
+
+	onScroll(event: React.UIEvent<HTMLDivElement>) {
+		const target = event.currentTarget
+		if (this.frame) cancelAnimationFrame(this.frame)
+		// re-render at most once per frame
+		this.frame = requestAnimationFrame(() => {
+			this.frame = undefined
+			this.setState({ scrollTop: target.scrollTop })
+			const bottom = target.scrollTop + target.clientHeight
+			if (bottom >= target.scrollHeight - this.props.rowHeight * 10)
+				this.props.onEndReached?.()
+		})
+	}
+
+	render() {
+		const { rowCount, rowHeight, height } = this.props
+		const overscan = this.props.overscan ?? 10
+		const first = Math.max(
+			Math.floor(this.state.scrollTop / rowHeight) - overscan,
+			0
+		)
+		const last = Math.min(
+			Math.ceil((this.state.scrollTop + height) / rowHeight) + overscan,
+			rowCount
+		)
+		const rows = []
+		for (let i = first; i < last; i++) rows.push(this.props.renderRow(i))
+
+		return (
+			<div
+				style={{ height, overflowY: "auto" }}
+				onScroll={this.onScroll.bind(this)}
+			>
+				<Table striped={true} variant="sm" className="text-nowrap">
+					<thead>{this.props.header}</thead>
+					<tbody>
+						<tr style={{ height: first * rowHeight }} />
+						{rows}
+						<tr style={{ height: (rowCount - last) * rowHeight }} />
+					</tbody>
+				</Table>
+			</div>
+		)
+	}
+}
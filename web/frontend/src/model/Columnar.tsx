@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Kuba Szczodrzyński 2026-10-19.
+ */
+
+// see web/columnar.py for the format description
+
+export const COLUMNAR_MEDIA_TYPE = "application/vnd.triplogger.columnar"
+
+export type Column = Float64Array | Int32Array
+
+export type Columnar = {
+	length: number
+	columns: { [name: string]: Column }
+}
+
+export function decodeColumnar(buffer: ArrayBuffer): Columnar {
+	const view = new DataView(buffer)
+	const magic = String.fromCharCode(
+		...new Uint8Array(buffer, 0, 4).values()
+	)
+	if (magic != "TLC1") throw new Error("Invalid columnar data")
+	const length = view.getUint32(4, true)
+	const count = view.getUint32(8, true)
+
+	let offset = 12
+	const header: [string, string][] = []
+	for (let i = 0; i < count; i++) {
+		const type = String.fromCharCode(view.getUint8(offset))
+		const nameLength = view.getUint8(offset + 1)
+		const name = new TextDecoder().decode(
+			new Uint8Array(buffer, offset + 2, nameLength)
+		)
+		header.push([name, type])
+		offset += 2 + nameLength
+	}
+
+	const columns: { [name: string]: Column } = {}
+	for (const [name, type] of header) {
+		offset += -offset & 7
+		// views into the response buffer - nothing is copied
+		if (type == "d") {
+			columns[name] = new Float64Array(buffer, offset, length)
+			offset += length * 8
+		} else if (type == "i") {
+			columns[name] = new Int32Array(buffer, offset, length)
+			offset += length * 4
+		} else {
+			throw new Error(`Unknown column type: ${type}`)
+		}
+	}
+	return { length, columns }
+}
+
+export async function fetchColumnar(
+	url: string
+): Promise<{ data: Columnar; response: Response }> {
+	const response = await fetch(url, {
+		headers: { Accept: COLUMNAR_MEDIA_TYPE },
+	})
+	const data = decodeColumnar(await response.arrayBuffer())
+	return { data, response }
+}
+
+export function columnMin(column: Column): number {
+	let result = Infinity
+	for (let i = 0; i < column.length; i++)
+		if (column[i] < result) result = column[i]
+	return result
+}
+
+export function columnMax(column: Column): number {
+	let result = -Infinity
+	for (let i = 0; i < column.length; i++)
+		if (column[i] > result) result = column[i]
+	return result
+}
+
+export function columnAvg(column: Column): number {
+	let sum = 0
+	for (let i = 0; i < column.length; i++) sum += column[i]
+	return sum / column.length
+}
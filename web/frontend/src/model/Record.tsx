@@ -3,6 +3,7 @@
  */
 
 import moment, { Moment } from "moment"
+import { Columnar } from "./Columnar"
 
 export type Record = {
 	startTime: Moment
@@ -49,3 +50,52 @@ export function mapToRecord(record: any): Record {
 		tripId: record.trip_id,
 	}
 }
+
+export type RecordColumns = {
+	length: number
+	startTime: Float64Array // milliseconds
+	endTime: Float64Array // milliseconds
+	startMileage: Float64Array
+	endMileage: Float64Array
+	dist: Float64Array // kilometers
+	fuel: Float64Array // liters
+	engineSpeed: Float64Array
+	engineSpeedMax: Float64Array
+	vehicleSpeedMin: Float64Array
+	vehicleSpeedMax: Float64Array
+	coolantTemp: Float64Array
+	outsideTemp: Float64Array
+	oilTemp: Float64Array
+	oilLevel: Float64Array
+	fuelLevel: Float64Array
+	fuelRange: Float64Array
+	fuelConsMin: Float64Array
+	fuelConsMax: Float64Array
+	tripId: Float64Array // NaN if not assigned
+}
+
+export function mapToRecordColumns(data: Columnar): RecordColumns {
+	const c = data.columns as { [name: string]: Float64Array }
+	return {
+		length: data.length,
+		startTime: c.start_time,
+		endTime: c.end_time,
+		startMileage: c.start_mileage,
+		endMileage: c.end_mileage,
+		dist: Float64Array.from(c.dist, (dist) => dist / 100.0 / 1000.0),
+		fuel: Float64Array.from(c.fuel, (fuel) => fuel / 1000.0 / 1000.0),
+		engineSpeed: c.engine_speed,
+		engineSpeedMax: c.engine_speed_max,
+		vehicleSpeedMin: c.vehicle_speed_min,
+		vehicleSpeedMax: c.vehicle_speed_max,
+		coolantTemp: c.coolant_temp,
+		outsideTemp: c.outside_temp,
+		oilTemp: c.oil_temp,
+		oilLevel: c.oil_level,
+		fuelLevel: c.fuel_level,
+		fuelRange: c.fuel_range,
+		fuelConsMin: c.fuel_cons_min,
+		fuelConsMax: c.fuel_cons_max,
+		tripId: c.trip_id,
+	}
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Kuba Szczodrzyński 2026-10-19.
+ */
+
+import { fetchColumnar } from "./Columnar"
+import { mapToRecordColumns, RecordColumns } from "./Record"
+
+export type RecordPage = {
+	records: RecordColumns
+	nextBefore?: number
+}
+
+/**
+ * Keeps pages of a trip's records, keyed by their time range cursor,
+ * so that going back to a page never downloads it again.
+ */
+export class RecordCache {
+	tripId: number
+	limit: number
+	pages = new Map<number | undefined, Promise<RecordPage>>()
+
+	constructor(tripId: number, limit: number) {
+		this.tripId = tripId
+		this.limit = limit
+	}
+
+	get(before?: number): Promise<RecordPage> {
+		let page = this.pages.get(before)
+		if (!page) {
+			page = this.fetch(before)
+			// forget failed requests, so that they can be retried
+			page.catch(() => this.pages.delete(before))
+			this.pages.set(before, page)
+		}
+		return page
+	}
+
+	async fetch(before?: number): Promise<RecordPage> {
+		let url = `/api/records?trip_id=${this.tripId}&limit=${this.limit}`
+		if (before) url += `&before=${before}`
+		const { data, response } = await fetchColumnar(url)
+		const cursor = response.headers.get("X-Next-Cursor")
+		return {
+			records: mapToRecordColumns(data),
+			nextBefore: cursor ? parseInt(cursor) : undefined,
+		}
+	}
+}
+
+export function concatRecords(
+	a: RecordColumns,
+	b: RecordColumns
+): RecordColumns {
+	const result: any = { length: a.length + b.length }
+	for (const key of Object.keys(a) as (keyof RecordColumns)[]) {
+		if (key == "length") continue
+		const column = new Float64Array(a.length + b.length)
+		column.set(a[key])
+		column.set(b[key], a.length)
+		result[key] = column
+	}
+	return result
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) Kuba Szczodrzyński 2026-10-19.
+ */
+
+import { fetchColumnar } from "./Columnar"
+
+export type Series = {
+	count: number // number of records before downsampling
+	time: Float64Array
+	values: { [metric: string]: Float64Array }
+}
+
+export async function fetchSeries(
+	tripId: number,
+	metrics: string[],
+	points: number,
+	start?: number,
+	end?: number
+): Promise<Series> {
+	let url = `/api/trips/${tripId}/series?points=${points}`
+	for (const metric of metrics) url += `&metrics=${metric}`
+	if (start !== undefined) url += `&start=${Math.floor(start)}`
+	if (end !== undefined) url += `&end=${Math.ceil(end)}`
+	const { data, response } = await fetchColumnar(url)
+	const values: { [metric: string]: Float64Array } = {}
+	for (const metric of metrics)
+		values[metric] = data.columns[metric] as Float64Array
+	return {
+		count: parseInt(response.headers.get("X-Series-Count") ?? "0"),
+		time: data.columns.t as Float64Array,
+		values,
+	}
+}
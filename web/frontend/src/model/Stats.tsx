@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) Kuba Szczodrzyński 2026-10-19.
+ */
+
+import moment, { duration, Duration, Moment } from "moment"
+
+export type StatsPeriod = "day" | "week" | "month" | "year"
+
+export type Stats = {
+	period: StatsPeriod
+	periodStart: Moment
+	trips: number
+	time: Duration
+	dist: number // kilometers
+	fuel: number // liters
+}
+
+export function mapToStats(stats: any): Stats {
+	return {
+		period: stats.period,
+		periodStart: moment(stats.period_start),
+		trips: stats.trips,
+		time: duration(stats.time),
+		dist: stats.dist / 100.0 / 1000.0,
+		fuel: stats.fuel / 1000.0 / 1000.0,
+	}
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Kuba Szczodrzyński 2026-10-19.
+ */
+
+import React from "react"
+import { ButtonGroup, Button, Table } from "react-bootstrap"
+import { mapToStats, Stats, StatsPeriod } from "../model/Stats"
+import moment from "moment"
+import "moment/dist/locale/pl"
+import "moment/locale/pl"
+
+type StatsPageState = {
+	period: StatsPeriod
+	stats?: Stats[]
+	error?: string
+}
+
+const PERIODS: { [period in StatsPeriod]: [string, string] } = {
+	day: ["Dni", "LL"],
+	week: ["Tygodnie", "[tydz.] W, GGGG"],
+	month: ["Miesiące", "MMMM YYYY"],
+	year: ["Lata", "YYYY"],
+}
+
+export default class StatsPage extends React.Component<any, StatsPageState> {
+	constructor(props: any) {
+		super(props)
+		this.state = { period: "month" }
+	}
+
+	render() {
+		if (!this.state.stats) {
+			if (!this.state.error) this.loadData()
+			return (
+				<div>
+					{this.state.error && <p>Błąd: {this.state.error}</p>}
+					{!this.state.error && <p>Ładowanie...</p>}
+				</div>
+			)
+		}
+
+		moment.locale("pl")
+
+		const largeUp = "d-none d-lg-table-cell"
+		const mediumUp = "d-none d-md-table-cell"
+		const format = PERIODS[this.state.period][1]
+		return (
+			<div>
+				<h2 className="mt-3">Statystyki</h2>
+				<ButtonGroup size="sm" className="mb-3">
+					{(Object.keys(PERIODS) as StatsPeriod[]).map((period) => (
+						<Button
+							key={period}
+							variant="outline-dark"
+							active={period == this.state.period}
+							onClick={() =>
+								this.setState({ period, stats: undefined })
+							}
+						>
+							{PERIODS[period][0]}
+						</Button>
+					))}
+				</ButtonGroup>
+				<Table responsive={true} striped={true} variant="sm">
+					<thead>
+						<tr>
+							<th>Okres</th>
+							<th className={mediumUp}>Trasy</th>
+							<th>Dystans</th>
+							<th className={largeUp}>Czas jazdy</th>
+							<th className={largeUp}>Paliwo</th>
+							<th>Śr. spalanie</th>
+						</tr>
+					</thead>
+					<tbody>
+						{this.state.stats.map((stats) => (
+							<tr key={stats.periodStart.valueOf()}>
+								<td>{stats.periodStart.format(format)}</td>
+								<td className={mediumUp}>{stats.trips}</td>
+								<td>{stats.dist.toFixed(2)} km</td>
+								<td className={largeUp}>
+									{Math.floor(stats.time.asHours())} h{" "}
+									{stats.time.minutes()} min
+								</td>
+								<td className={largeUp}>
+									{stats.fuel.toFixed(2)} l
+								</td>
+								<td>
+									{((stats.fuel / stats.dist) * 100.0).toFixed(
+										2
+									)}{" "}
+									l/100 km
+								</td>
+							</tr>
+						))}
+					</tbody>
+				</Table>
+			</div>
+		)
+	}
+
+	async loadData() {
+		const url = `/api/stats?period=${this.state.period}`
+		const response = await fetch(url)
+		const statsList: any[] = await response.json()
+		const stats: Stats[] = statsList.map(mapToStats)
+		this.setState({ stats })
+	}
+}
@@ -4,15 +4,18 @@
 
 import React from "react"
 import { mapToTrip, Trip } from "../model/Trip"
-import { mapToRecord, Record } from "../model/Record"
-import moment, { duration } from "moment"
+import { RecordColumns } from "../model/Record"
+import { concatRecords, RecordCache } from "../model/RecordCache"
+import { fetchSeries } from "../model/Series"
+import moment from "moment"
 import "moment/dist/locale/pl"
 import "moment/locale/pl"
-import { Button, PageItem, Pagination, Table } from "react-bootstrap"
+import { Button } from "react-bootstrap"
 import { LinkContainer } from "react-router-bootstrap"
 import StatCard from "../components/StatCard"
+import VirtualTable from "../components/VirtualTable"
 import { Line } from "react-chartjs-2"
-import { Chart, ChartData, ChartOptions } from "chart.js"
+import { Chart, ChartData, ChartOptions, ScatterDataPoint } from "chart.js"
 
 // @ts-ignore
 import zoomPlugin from "chartjs-plugin-zoom"
@@ -23,50 +26,55 @@ type TripPageProps = {
 
 type TripPageState = {
 	trip?: Trip
-	records?: Record[]
+	records?: RecordColumns
 	error?: string
-	before?: number
-	prevBefore: (number | undefined)[]
+	nextBefore?: number
+	loading: boolean
 }
 
 Chart.register(zoomPlugin)
 
+const SERIES_METRICS = ["speed", "fuel_cons"]
+const SERIES_POINTS = 500
+const RECORDS_LIMIT = 100
+const ROW_HEIGHT = 31
+
 export default class TripPage extends React.Component<
 	TripPageProps,
 	TripPageState
 > {
-	constructor(props: any) {
-		super(props)
-		this.state = { prevBefore: [] }
+	recordCache: RecordCache
+	chart = React.createRef<Chart<"line">>()
+	chartOptions: ChartOptions<"line">
+	// datasets are kept between renders and updated in place
+	chartData: ChartData<"line"> = {
+		datasets: [
+			{
+				label: "Prędkość",
+				data: [],
+				borderColor: "#D664BE",
+				backgroundColor: "transparent",
+				yAxisID: "ySpeed",
+			},
+			{
+				label: "Spalanie",
+				data: [],
+				borderColor: "#FEB95F",
+				backgroundColor: "transparent",
+				yAxisID: "yFuel",
+			},
+		],
 	}
 
-	render() {
-		if (!this.state.trip) {
-			if (!this.state.error) this.loadTrip()
-			return (
-				<div>
-					{this.state.error && <p>Błąd: {this.state.error}</p>}
-					{!this.state.error && <p>Ładowanie...</p>}
-				</div>
-			)
-		}
-		if (!this.state.records) {
-			if (!this.state.error) this.loadRecords()
-			return (
-				<div>
-					{this.state.error && <p>Błąd: {this.state.error}</p>}
-					{!this.state.error && <p>Ładowanie...</p>}
-				</div>
-			)
-		}
-
-		moment.locale("pl")
-
-		const trip = this.state.trip
-		this.state.records.sort((a, b) => a.startTime.diff(b.startTime))
-
-		const chartOptions: ChartOptions<"line"> = {
+	constructor(props: TripPageProps) {
+		super(props)
+		this.state = { loading: false }
+		this.recordCache = new RecordCache(props.tripId, RECORDS_LIMIT)
+		this.chartOptions = {
 			responsive: true,
+			animation: false,
+			parsing: false,
+			normalized: true,
 			scales: {
 				x: {
 					type: "linear",
@@ -131,48 +139,47 @@ export default class TripPage extends React.Component<
 							enabled: true,
 						},
 						mode: "x",
+						onZoomComplete: this.onChartZoom.bind(this),
 					},
 					pan: {
 						enabled: true,
 						mode: "x",
+						onPanComplete: this.onChartZoom.bind(this),
 					},
 				},
 			},
 		}
+	}
 
-		const labels = this.state.records.map((record) => record.startTime)
+	componentDidMount() {
+		this.loadSeries()
+	}
 
-		const chartData: ChartData<"line"> = {
-			labels,
-			datasets: [
-				{
-					label: "Prędkość",
-					data: this.state.records.map(
-						(record) =>
-							record.dist /
-							duration(
-								record.endTime.diff(record.startTime)
-							).asHours()
-					),
-					borderColor: "#D664BE",
-					backgroundColor: "transparent",
-					yAxisID: "ySpeed",
-				},
-				{
-					label: "Spalanie",
-					data: this.state.records.map(
-						(record) => (record.fuel / record.dist) * 100.0
-					),
-					borderColor: "#FEB95F",
-					backgroundColor: "transparent",
-					yAxisID: "yFuel",
-				},
-			],
+	render() {
+		if (!this.state.trip) {
+			if (!this.state.error) this.loadTrip()
+			return (
+				<div>
+					{this.state.error && <p>Błąd: {this.state.error}</p>}
+					{!this.state.error && <p>Ładowanie...</p>}
+				</div>
+			)
+		}
+		if (!this.state.records) {
+			if (!this.state.error) this.loadRecords()
+			return (
+				<div>
+					{this.state.error && <p>Błąd: {this.state.error}</p>}
+					{!this.state.error && <p>Ładowanie...</p>}
+				</div>
+			)
 		}
 
-		const chart = <Line options={chartOptions} data={chartData} />
+		moment.locale("pl")
 
-		this.state.records.sort((a, b) => b.startTime.diff(a.startTime))
+		const trip = this.state.trip
+		// records are returned newest first
+		const records = this.state.records
 
 		const largeUp = "d-none d-lg-table-cell"
 		const mediumUp = "d-none d-md-table-cell"
@@ -214,16 +221,7 @@ export default class TripPage extends React.Component<
 							(trip.dist / trip.time.asHours()).toFixed(1) +
 							" km/h"
 						}
-						min={Math.min(
-							...this.state.records.map(
-								(record) => record.vehicleSpeedMin
-							)
-						).toFixed(1)}
-						max={Math.max(
-							...this.state.records.map(
-								(record) => record.vehicleSpeedMax
-							)
-						).toFixed(1)}
+						max={trip.vehicleSpeedMax.toFixed(1)}
 					/>
 					<StatCard
 						title="Śr. spalanie"
@@ -231,66 +229,36 @@ export default class TripPage extends React.Component<
 							((trip.fuel / trip.dist) * 100.0).toFixed(2) +
 							" l/100 km"
 						}
-						min={Math.min(
-							...this.state.records.map(
-								(record) => record.fuelConsMin
-							)
-						).toFixed(1)}
-						max={Math.max(
-							...this.state.records.map(
-								(record) => record.fuelConsMax
-							)
-						).toFixed(1)}
+						min={trip.fuelConsMin.toFixed(1)}
+						max={trip.fuelConsMax.toFixed(1)}
 					/>
 					<StatCard
 						title="Temp. otoczenia"
-						value={
-							(
-								this.state.records.reduce(
-									(sum, record) => sum + record.outsideTemp,
-									0
-								) / this.state.records.length
-							).toFixed(1) + "°C"
-						}
-						min={Math.min(
-							...this.state.records.map(
-								(record) => record.outsideTemp
-							)
-						).toFixed(1)}
-						max={Math.max(
-							...this.state.records.map(
-								(record) => record.outsideTemp
-							)
-						).toFixed(1)}
+						value={trip.outsideTempAvg.toFixed(1) + "°C"}
+						min={trip.outsideTempMin.toFixed(1)}
+						max={trip.outsideTempMax.toFixed(1)}
 					/>
 					<StatCard
 						title="Temp. silnika"
-						value={
-							(
-								this.state.records.reduce(
-									(sum, record) => sum + record.coolantTemp,
-									0
-								) / this.state.records.length
-							).toFixed(1) + "°C"
-						}
-						min={Math.min(
-							...this.state.records.map(
-								(record) => record.coolantTemp
-							)
-						).toFixed(1)}
-						max={Math.max(
-							...this.state.records.map(
-								(record) => record.coolantTemp
-							)
-						).toFixed(1)}
+						value={trip.coolantTempAvg.toFixed(1) + "°C"}
+						min={trip.coolantTempMin.toFixed(1)}
+						max={trip.coolantTempMax.toFixed(1)}
 					/>
 				</div>
 
-				{chart}
+				<Line
+					ref={this.chart}
+					options={this.chartOptions}
+					data={this.chartData}
+				/>
 
 				<h2 className="my-3">Odcinki trasy</h2>
-				<Table responsive={true} striped={true} variant="sm">
-					<thead>
+				<VirtualTable
+					rowCount={records.length}
+					rowHeight={ROW_HEIGHT}
+					height={ROW_HEIGHT * 20}
+					onEndReached={this.loadMoreRecords.bind(this)}
+					header={
 						<tr>
 							<th>Godzina</th>
 							<th>Dystans</th>
@@ -307,95 +275,63 @@ export default class TripPage extends React.Component<
 							<th className={largeUp}>Temp. silnika</th>
 							<th className={largeUp}>Zasięg</th>
 						</tr>
-					</thead>
-					<tbody>
-						{this.state.records.map((record) => (
-							<tr>
-								<td>{record.startTime.format("HH:mm")}</td>
-								<td>{record.dist.toFixed(2)} km</td>
-								<td className={largeUp}>
-									{record.fuel.toFixed(2)} l (
-									{record.fuelLevel.toFixed(0)}%)
-								</td>
-								<td>
-									{(
-										record.dist /
-										duration(
-											record.endTime.diff(
-												record.startTime
-											)
-										).asHours()
-									).toFixed(1)}{" "}
-									km/h{" "}
-									<small className={smallText}>
-										({record.vehicleSpeedMin.toFixed(1)} /{" "}
-										{record.vehicleSpeedMax.toFixed(1)})
-									</small>
-								</td>
-								<td>
-									{(
-										(record.fuel / record.dist) *
-										100.0
-									).toFixed(2)}{" "}
-									l/100 km{" "}
-									<small className={smallText}>
-										({record.fuelConsMin.toFixed(1)} /{" "}
-										{record.fuelConsMax.toFixed(1)})
-									</small>
-								</td>
-								<td className={mediumUp}>
-									{record.outsideTemp.toFixed(1)}°C
-								</td>
-								<td className={largeUp}>
-									{record.coolantTemp.toFixed(1)}°C
-								</td>
-								<td className={largeUp}>
-									{record.fuelRange.toFixed(0)} km
-								</td>
-							</tr>
-						))}
-					</tbody>
-				</Table>
-				<Pagination>
-					<PageItem
-						disabled={this.state.prevBefore.length == 0}
-						onClick={this.onPagePrevClick.bind(this)}
-					>
-						&laquo; Następne
-					</PageItem>
-					<PageItem
-						disabled={this.state.records.length != 100}
-						onClick={this.onPageNextClick.bind(this)}
-					>
-						Poprzednie &raquo;
-					</PageItem>
-				</Pagination>
+					}
+					renderRow={(i) => (
+						<tr
+							key={records.startTime[i]}
+							style={{ height: ROW_HEIGHT }}
+						>
+							<td>
+								{moment(records.startTime[i]).format("HH:mm")}
+							</td>
+							<td>{records.dist[i].toFixed(2)} km</td>
+							<td className={largeUp}>
+								{records.fuel[i].toFixed(2)} l (
+								{records.fuelLevel[i].toFixed(0)}%)
+							</td>
+							<td>
+								{(
+									(records.dist[i] /
+										(records.endTime[i] -
+											records.startTime[i])) *
+									3600000.0
+								).toFixed(1)}{" "}
+								km/h{" "}
+								<small className={smallText}>
+									({records.vehicleSpeedMin[i].toFixed(1)} /{" "}
+									{records.vehicleSpeedMax[i].toFixed(1)})
+								</small>
+							</td>
+							<td>
+								{(
+									(records.fuel[i] / records.dist[i]) *
+									100.0
+								).toFixed(2)}{" "}
+								l/100 km{" "}
+								<small className={smallText}>
+									({records.fuelConsMin[i].toFixed(1)} /{" "}
+									{records.fuelConsMax[i].toFixed(1)})
+								</small>
+							</td>
+							<td className={mediumUp}>
+								{records.outsideTemp[i].toFixed(1)}°C
+							</td>
+							<td className={largeUp}>
+								{records.coolantTemp[i].toFixed(1)}°C
+							</td>
+							<td className={largeUp}>
+								{records.fuelRange[i].toFixed(0)} km
+							</td>
+						</tr>
+					)}
+				/>
 			</div>
 		)
 	}
 
-	onPagePrevClick() {
-		if (!this.state.records) return
-		const newBefore = this.state.prevBefore.pop()
-		this.setState({
-			records: undefined,
-			before: newBefore,
-			prevBefore: Array.of(...this.state.prevBefore),
-		})
-	}
-
-	onPageNextClick() {
-		if (!this.state.records?.length) return
-		const newBefore = Math.min(
-			...this.state.records.map((trip) =>
-				parseInt(trip.startTime.format("x"))
-			)
-		)
-		this.setState({
-			records: undefined,
-			before: newBefore,
-			prevBefore: Array.of(...this.state.prevBefore, this.state.before),
-		})
+	onChartZoom({ chart }: { chart: Chart }) {
+		const { min, max } = chart.scales.x
+		this.loadSeries(min, max)
 	}
 
 	async loadTrip() {
@@ -407,11 +343,57 @@ export default class TripPage extends React.Component<
 	}
 
 	async loadRecords() {
-		let url = `/api/records?trip_id=${this.props.tripId}&limit=100`
-		if (this.state.before) url += `&before=${this.state.before}`
-		const response = await fetch(url)
-		const recordList: any[] = await response.json()
-		const records: Record[] = recordList.map(mapToRecord)
-		this.setState({ records })
+		const page = await this.recordCache.get()
+		this.setState({ records: page.records, nextBefore: page.nextBefore })
+	}
+
+	async loadMoreRecords() {
+		if (!this.state.records || !this.state.nextBefore) return
+		if (this.state.loading) return
+		this.setState({ loading: true })
+		const page = await this.recordCache.get(this.state.nextBefore)
+		this.setState({
+			records: concatRecords(this.state.records, page.records),
+			nextBefore: page.nextBefore,
+			loading: false,
+		})
+	}
+
+	async loadSeries(start?: number, end?: number) {
+		// fetch a downsampled series covering the visible time range
+		const series = await fetchSeries(
+			this.props.tripId,
+			SERIES_METRICS,
+			SERIES_POINTS,
+			start,
+			end
+		)
+		const from = start ?? -Infinity
+		const to = end ?? Infinity
+		// replace the points of that range with the more detailed ones
+		const chartData = this.chart.current?.data ?? this.chartData
+		SERIES_METRICS.forEach((metric, i) => {
+			const data = chartData.datasets[i].data as ScatterDataPoint[]
+			const values = series.values[metric]
+			const points: ScatterDataPoint[] = []
+			series.time.forEach((x, j) => {
+				if (x >= from && x < to) points.push({ x, y: values[j] })
+			})
+			const first = lowerBound(data, from)
+			const last = lowerBound(data, to)
+			data.splice(first, last - first, ...points)
+		})
+		this.chart.current?.update("none")
+	}
+}
+
+function lowerBound(data: ScatterDataPoint[], x: number): number {
+	let lo = 0
+	let hi = data.length
+	while (lo < hi) {
+		const mid = (lo + hi) >> 1
+		if (data[mid].x < x) lo = mid + 1
+		else hi = mid
 	}
+	return lo
 }
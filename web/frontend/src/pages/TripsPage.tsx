@@ -9,12 +9,14 @@ import moment, { duration } from "moment"
 import "moment/dist/locale/pl"
 import "moment/locale/pl"
 import StatCard from "../components/StatCard"
+import LiveStats from "../components/LiveStats"
 import { Link } from "react-router-dom"
 
 type TripsPageState = {
 	trips?: Trip[]
 	error?: string
 	before?: number
+	nextBefore?: number
 	prevBefore: (number | undefined)[]
 }
 
@@ -45,6 +47,7 @@ export default class TripsPage extends React.Component<any, TripsPageState> {
 		const largeDown = "d-xl-none"
 		return (
 			<div>
+				<LiveStats />
 				<h2 className="mt-3 mb-0">Podsumowanie</h2>
 				<small className="m-0">
 					{this.state.trips[
@@ -203,7 +206,7 @@ export default class TripsPage extends React.Component<any, TripsPageState> {
 						&laquo; Następne
 					</PageItem>
 					<PageItem
-						disabled={this.state.trips.length != 20}
+						disabled={!this.state.nextBefore}
 						onClick={this.onPageNextClick.bind(this)}
 					>
 						Poprzednie &raquo;
@@ -224,12 +227,8 @@ export default class TripsPage extends React.Component<any, TripsPageState> {
 	}
 
 	onPageNextClick() {
-		if (!this.state.trips?.length) return
-		const newBefore = Math.min(
-			...this.state.trips.map((trip) =>
-				parseInt(trip.startTime.format("x"))
-			)
-		)
+		if (!this.state.nextBefore) return
+		const newBefore = this.state.nextBefore
 		this.setState({
 			trips: undefined,
 			before: newBefore,
@@ -243,6 +242,8 @@ export default class TripsPage extends React.Component<any, TripsPageState> {
 		const response = await fetch(url)
 		const tripList: any[] = await response.json()
 		const trips: Trip[] = tripList.map(mapToTrip)
-		this.setState({ trips })
+		const cursor = response.headers.get("X-Next-Cursor")
+		const nextBefore = cursor ? parseInt(cursor) : undefined
+		this.setState({ trips, nextBefore })
 	}
 }
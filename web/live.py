@@ -0,0 +1,163 @@
+#  Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+import asyncio
+import json
+import os
+import socket
+import struct
+from collections import deque
+from typing import AsyncIterator
+
+# must match live_packet_t and live_alert_packet_t in src/live.h
+LIVE_MAGIC = 0x564C544C
+LIVE_VERSION = 1
+LIVE_TYPE_RECORD = 1
+LIVE_TYPE_ALERT = 2
+LIVE_HEADER = struct.Struct("<IHHIQ")
+LIVE_STRUCT = struct.Struct("<IHHIQ" "QQIIfff" "fffffffffd")
+LIVE_FIELDS = (
+    "magic",
+    "version",
+    "type",
+    "seq",
+    "time",
+    # current record
+    "start_time",
+    "end_time",
+    "dist",
+    "fuel",
+    "engine_speed_avg",
+    "vehicle_speed_avg",
+    "fuel_cons_avg",
+    # latest decoded values
+    "engine_speed",
+    "vehicle_speed",
+    "coolant_temp",
+    "outside_temp",
+    "oil_temp",
+    "oil_level",
+    "fuel_level",
+    "fuel_cons",
+    "fuel_range",
+    "mileage",
+)
+LIVE_ALERT_STRUCT = struct.Struct("<IHHIQ" "32s16sBff")
+LIVE_ALERT_FIELDS = (
+    "magic",
+    "version",
+    "type",
+    "seq",
+    "time",
+    # alert
+    "rule",
+    "signal",
+    "active",
+    "value",
+    "limit",
+)
+
+
+def decode_packet(data: bytes) -> dict | None:
+    if len(data) < LIVE_HEADER.size:
+        return None
+    magic, version, packet_type, _, _ = LIVE_HEADER.unpack_from(data)
+    if magic != LIVE_MAGIC or version != LIVE_VERSION:
+        return None
+    if packet_type == LIVE_TYPE_RECORD:
+        packet_struct, fields = LIVE_STRUCT, LIVE_FIELDS
+    elif packet_type == LIVE_TYPE_ALERT:
+        packet_struct, fields = LIVE_ALERT_STRUCT, LIVE_ALERT_FIELDS
+    else:
+        return None
+    if len(data) < packet_struct.size:
+        return None
+    packet = dict(zip(fields, packet_struct.unpack_from(data)))
+    del packet["magic"]
+    del packet["version"]
+    if packet_type == LIVE_TYPE_ALERT:
+        packet["rule"] = packet["rule"].rstrip(b"\0").decode()
+        packet["signal"] = packet["signal"].rstrip(b"\0").decode()
+        packet["active"] = bool(packet["active"])
+        # NaN isn't valid JSON
+        if packet["value"] != packet["value"]:
+            packet["value"] = None
+    return packet
+
+
+class LiveSubscriber:
+    """
+    A single client. Only the latest record packet is kept, so a slow client
+    skips intermediate packets instead of queueing them. Alerts are queued
+    (up to a limit), as each of them is sent only once.
+    """
+
+    def __init__(self):
+        self.latest: dict | None = None
+        self.alerts: deque[dict] = deque(maxlen=16)
+        self.event = asyncio.Event()
+
+    def push(self, packet: dict):
+        if packet["type"] == LIVE_TYPE_ALERT:
+            self.alerts.append(packet)
+        else:
+            self.latest = packet
+        self.event.set()
+
+    async def pop(self) -> dict:
+        await self.event.wait()
+        if self.alerts:
+            packet = self.alerts.popleft()
+        else:
+            packet, self.latest = self.latest, None
+        if not self.alerts and self.latest is None:
+            self.event.clear()
+        return packet
+
+
+class LiveHub(asyncio.DatagramProtocol):
+    """
+    Receives telemetry datagrams from the logger and fans them out to subscribers.
+    """
+
+    def __init__(self, path: str):
+        self.path = path
+        self.subscribers: set[LiveSubscriber] = set()
+        self.transport: asyncio.DatagramTransport | None = None
+
+    async def start(self):
+        if os.path.exists(self.path):
+            os.unlink(self.path)
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_DGRAM)
+        sock.bind(self.path)
+        loop = asyncio.get_running_loop()
+        await loop.create_datagram_endpoint(lambda: self, sock=sock)
+
+    def stop(self):
+        if self.transport:
+            self.transport.close()
+        if os.path.exists(self.path):
+            os.unlink(self.path)
+
+    def connection_made(self, transport):
+        self.transport = transport
+
+    def datagram_received(self, data: bytes, addr):
+        packet = decode_packet(data)
+        if packet is None:
+            return
+        for subscriber in self.subscribers:
+            subscriber.push(packet)
+
+    async def stream(self, rate: float) -> AsyncIterator[str]:
+        """
+        Yield Server-Sent Events, at most `rate` per second.
+        """
+        subscriber = LiveSubscriber()
+        self.subscribers.add(subscriber)
+        try:
+            while True:
+                packet = await subscriber.pop()
+                yield f"data: {json.dumps(packet, separators=(',', ':'))}\n\n"
+                await asyncio.sleep(1.0 / rate)
+        finally:
+            self.subscribers.discard(subscriber)
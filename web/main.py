@@ -1,143 +1,289 @@
 #  Copyright (c) Kuba Szczodrzyński 2025-1-26.
 
+import asyncio
+import os
+from contextlib import asynccontextmanager
 from typing import Annotated
 
-from fastapi import Depends, FastAPI, HTTPException, Query
+from fastapi import FastAPI, HTTPException, Query, Request
 from fastapi.middleware.cors import CORSMiddleware
-from fastapi.staticfiles import StaticFiles
-from sqlmodel import Session, create_engine, select, func
-from starlette.exceptions import HTTPException as StarletteHTTPException
+from fastapi.responses import Response, StreamingResponse
+from sqlmodel import Session, select
 
-from .model.record import Record
-from .model.trip import Trip, TripNoId
+from .cache import DataVersion, ResponseCache
+from .columnar import (
+    COLUMNAR_MEDIA_TYPE,
+    encode_columnar,
+    rows_to_columns,
+    wants_columnar,
+)
+from .db import run_session
+from .live import LiveHub
+from .model.alert import Alert
+from .model.record import RECORD_COLUMNAR, RECORD_COLUMNS, Record
+from .model.scale import column_sql
+from .model.stats import StatsPeriod, TripStats
+from .model.trip import Trip, TripCurrent, TripNoId
+from .partition import select_records, trip_range
+from .series import SERIES_METRICS, downsample, metric_columns
+from .static import SPAStaticFiles
+
+response_cache = ResponseCache(DataVersion())
 
-sqlite_file_name = "canlogger.db"
-sqlite_url = f"sqlite:///{sqlite_file_name}"
+live_socket = os.environ.get("LIVE_SOCKET", "/tmp/triplogger-live.sock")
+live_max_rate = float(os.environ.get("LIVE_MAX_RATE", "5"))
+live_hub = LiveHub(live_socket)
 
-connect_args = dict(check_same_thread=False)
-engine = create_engine(sqlite_url, connect_args=connect_args)
+metrics_socket = os.environ.get("METRICS_SOCKET", "/tmp/triplogger-metrics.sock")
 
 
-def get_session():
-    with Session(engine) as session:
-        yield session
+@asynccontextmanager
+async def lifespan(_: FastAPI):
+    await live_hub.start()
+    yield
+    live_hub.stop()
 
 
-SessionDep = Annotated[Session, Depends(get_session)]
-app = FastAPI()
+app = FastAPI(lifespan=lifespan)
 app.add_middleware(
     CORSMiddleware,
     allow_origins=["*"],
     allow_credentials=True,
     allow_methods=["*"],
     allow_headers=["*"],
+    expose_headers=["ETag", "X-Next-Cursor", "X-Series-Count"],
 )
 
 
+def next_cursor(
+    items: list,
+    limit: int,
+    start_time=lambda item: item.start_time,
+    ascending: bool = False,
+) -> dict:
+    # a full page means there might be more items - return the keyset cursor:
+    # the next "before" when paging backwards, the next "after" when paging forwards
+    if not items or len(items) < limit:
+        return {}
+    cursor = max if ascending else min
+    return {"X-Next-Cursor": str(cursor(start_time(item) for item in items))}
+
+
 @app.get("/api/records", response_model=list[Record])
 async def get_record_list(
-    session: SessionDep,
+    request: Request,
     after: int = None,
     before: int = None,
     trip_id: int = None,
     limit: Annotated[int, Query(le=100)] = 20,
 ):
-    stmt = select(Record)
-    order_by = Record.start_time.desc()
-    if after is not None:
-        stmt = stmt.where(Record.start_time > after)
-        order_by = Record.start_time
-    if before is not None:
-        stmt = stmt.where(Record.end_time < before)
-    stmt = stmt.order_by(order_by)
-    if trip_id is not None:
-        stmt = stmt.where(Record.trip_id == trip_id)
-    return session.exec(stmt.limit(limit)).all()
+    columnar = wants_columnar(request)
+
+    def query(session: Session):
+        # read plain rows, without building a model object for each of them
+        where = "1"
+        params = []
+        start, end = trip_range(session, trip_id) if trip_id is not None else (None, None)
+        if after is not None:
+            where += " AND start_time > ?"
+            params.append(after)
+            start = max(start or after, after)
+        if before is not None:
+            where += " AND start_time < ?"
+            params.append(before)
+            end = min(end or before, before)
+        if trip_id is not None:
+            where += " AND trip_id = ?"
+            params.append(trip_id)
+        rows = select_records(
+            session,
+            ", ".join(map(column_sql, RECORD_COLUMNS)),
+            where,
+            params,
+            start,
+            end,
+            descending=after is None,
+            limit=limit,
+        )
+        headers = next_cursor(rows, limit, lambda row: row[0], after is not None)
+        if columnar:
+            columns = rows_to_columns(rows, len(RECORD_COLUMNAR))
+            return encode_columnar(RECORD_COLUMNAR, columns), headers
+        return [dict(zip(RECORD_COLUMNS, row)) for row in rows], headers
+
+    key = ("records", columnar, after, before, trip_id, limit)
+    media_type = COLUMNAR_MEDIA_TYPE if columnar else "application/json"
+    return await response_cache.respond(request, key, query, media_type)
 
 
 @app.get("/api/trips", response_model=list[TripNoId])
 async def get_trip_list(
-    session: SessionDep,
+    request: Request,
     after: int = None,
     before: int = None,
     limit: Annotated[int, Query(le=100)] = 20,
 ):
-    current_trip = []
-    if after is None and before is None:
-        # noinspection PyArgumentList
-        stmt = (
-            select(
-                Record.trip_id,
-                func.sum(Record.end_time - Record.start_time).label("time"),
-                func.sum(Record.dist).label("dist"),
-                func.sum(Record.fuel).label("fuel"),
-                func.min(Record.start_time).label("start_time"),
-                func.max(Record.end_time).label("end_time"),
-                func.min(Record.start_mileage).label("start_mileage"),
-                func.max(Record.end_mileage).label("end_mileage"),
-                func.max(Record.engine_speed_max).label("engine_speed_max"),
-                func.max(Record.vehicle_speed_max).label("vehicle_speed_max"),
-                (func.sum(Record.coolant_temp) / func.count(Record.coolant_temp)).label(
-                    "coolant_temp_avg"
-                ),
-                func.min(Record.coolant_temp).label("coolant_temp_min"),
-                func.max(Record.coolant_temp).label("coolant_temp_max"),
-                (func.sum(Record.outside_temp) / func.count(Record.outside_temp)).label(
-                    "outside_temp_avg"
-                ),
-                func.min(Record.outside_temp).label("outside_temp_min"),
-                func.max(Record.outside_temp).label("outside_temp_max"),
-                (func.sum(Record.oil_temp) / func.count(Record.oil_temp)).label(
-                    "oil_temp_avg"
-                ),
-                func.min(Record.oil_temp).label("oil_temp_min"),
-                func.max(Record.oil_temp).label("oil_temp_max"),
-                func.min(Record.oil_level).label("oil_level_min"),
-                func.max(Record.oil_level).label("oil_level_max"),
-                func.min(Record.fuel_level).label("fuel_level_min"),
-                func.max(Record.fuel_level).label("fuel_level_max"),
-                func.min(Record.fuel_range).label("fuel_range_min"),
-                func.max(Record.fuel_range).label("fuel_range_max"),
-                func.min(Record.fuel_cons_min).label("fuel_cons_min"),
-                func.max(Record.fuel_cons_max).label("fuel_cons_max"),
-            )
-            .where(Record.trip_id.is_(None))
-            .group_by(Record.trip_id)
-        )
-        trip = session.exec(stmt.limit(1)).first()
-        if trip:
-            current_trip = [trip]
-            limit -= 1
-    stmt = select(Trip)
-    order_by = Trip.start_time.desc()
-    if after is not None:
-        stmt = stmt.where(Trip.start_time > after)
-        order_by = Trip.start_time
-    if before is not None:
-        stmt = stmt.where(Trip.end_time < before)
-    stmt = stmt.order_by(order_by)
-    return current_trip + session.exec(stmt.limit(limit)).all()
+    def query(session: Session):
+        nonlocal limit
+        current_trip = []
+        if after is None and before is None:
+            # the logger keeps the in-progress trip in a single row
+            trip = session.get(TripCurrent, 0)
+            if trip:
+                current_trip = [TripNoId(**{**trip.model_dump(), "trip_id": None})]
+                limit -= 1
+        stmt = select(Trip)
+        order_by = Trip.start_time.desc()
+        if after is not None:
+            stmt = stmt.where(Trip.start_time > after)
+            order_by = Trip.start_time
+        if before is not None:
+            stmt = stmt.where(Trip.start_time < before)
+        stmt = stmt.order_by(order_by)
+        trips = session.exec(stmt.limit(limit)).all()
+        headers = next_cursor(trips, limit, ascending=after is not None)
+        return current_trip + trips, headers
+
+    key = ("trips", after, before, limit)
+    return await response_cache.respond(request, key, query)
 
 
 @app.get("/api/trips/{trip_id}", response_model=Trip)
 async def get_trip_single(
-    session: SessionDep,
     trip_id: int,
 ):
-    trip = session.get(Trip, trip_id)
+    trip = await run_session(lambda session: session.get(Trip, trip_id))
     if not trip:
         raise HTTPException(status_code=404, detail="Trip not found")
     return trip
 
 
-class SPAStaticFiles(StaticFiles):
-    async def get_response(self, path: str, scope):
+@app.get("/api/trips/{trip_id}/series")
+async def get_trip_series(
+    request: Request,
+    trip_id: int,
+    metrics: Annotated[list[str], Query()] = ["speed", "fuel_cons"],
+    points: Annotated[int, Query(ge=10, le=5000)] = 500,
+    start: int = None,
+    end: int = None,
+):
+    unknown = [metric for metric in metrics if metric not in SERIES_METRICS]
+    if unknown:
+        raise HTTPException(status_code=400, detail=f"Unknown metrics: {unknown}")
+    columnar = wants_columnar(request)
+
+    def query(session: Session):
+        columns = metric_columns(metrics)
+        trip_start, trip_end = trip_range(session, trip_id)
+        if trip_start is None:
+            raise HTTPException(status_code=404, detail="Trip not found")
+        where = "trip_id = ?"
+        params = [trip_id]
+        if start is not None:
+            where += " AND end_time > ?"
+            params.append(start)
+        if end is not None:
+            where += " AND start_time < ?"
+            params.append(end)
+        rows = select_records(
+            session,
+            ", ".join(map(column_sql, columns)),
+            where,
+            params,
+            max(trip_start, start or trip_start),
+            min(trip_end, end or trip_end),
+        )
+        series = downsample(metrics, columns, rows, points)
+        if columnar:
+            headers = {"X-Series-Count": str(series["count"])}
+            return encode_columnar(
+                [("t", "d")] + [(metric, "d") for metric in metrics],
+                [series["t"]] + [series["values"][metric] for metric in metrics],
+            ), headers
+        return series, {}
+
+    key = ("series", columnar, trip_id, tuple(metrics), points, start, end)
+    media_type = COLUMNAR_MEDIA_TYPE if columnar else "application/json"
+    return await response_cache.respond(request, key, query, media_type)
+
+
+@app.get("/api/stats", response_model=list[TripStats])
+async def get_stats(
+    request: Request,
+    period: StatsPeriod = "month",
+    start: int = None,
+    end: int = None,
+):
+    def query(session: Session):
+        # a range scan of the trip_stats primary key
+        stmt = select(TripStats).where(TripStats.period == period)
+        if start is not None:
+            stmt = stmt.where(TripStats.period_start >= start)
+        if end is not None:
+            stmt = stmt.where(TripStats.period_start < end)
+        stmt = stmt.order_by(TripStats.period_start.desc())
+        return session.exec(stmt).all(), {}
+
+    key = ("stats", period, start, end)
+    return await response_cache.respond(request, key, query)
+
+
+@app.get("/api/alerts", response_model=list[Alert])
+async def get_alert_list(
+    request: Request,
+    before: int = None,
+    rule: str = None,
+    active: bool = None,
+    limit: Annotated[int, Query(le=100)] = 20,
+):
+    def query(session: Session):
+        # newest first, paginated by start_time like the trips
+        stmt = select(Alert)
+        if before is not None:
+            stmt = stmt.where(Alert.start_time < before)
+        if rule is not None:
+            stmt = stmt.where(Alert.rule == rule)
+        if active is not None:
+            stmt = stmt.where(
+                Alert.end_time.is_(None) if active else Alert.end_time.is_not(None)
+            )
+        stmt = stmt.order_by(Alert.start_time.desc())
+        alerts = session.exec(stmt.limit(limit)).all()
+        return alerts, next_cursor(alerts, limit)
+
+    key = ("alerts", before, rule, active, limit)
+    return await response_cache.respond(request, key, query)
+
+
+@app.get("/api/live")
+async def get_live(
+    rate: Annotated[float, Query(gt=0)] = live_max_rate,
+):
+    return StreamingResponse(
+        live_hub.stream(min(rate, live_max_rate)),
+        media_type="text/event-stream",
+        headers={"Cache-Control": "no-cache"},
+    )
+
+
+@app.get("/metrics")
+async def get_metrics():
+    # re-export the logger's metrics (Prometheus text format)
+    try:
+        reader, writer = await asyncio.wait_for(
+            asyncio.open_unix_connection(metrics_socket), timeout=1.0
+        )
         try:
-            return await super().get_response(path, scope)
-        except (HTTPException, StarletteHTTPException) as e:
-            if e.status_code == 404:
-                return await super().get_response("index.html", scope)
-            raise e
+            data = await asyncio.wait_for(reader.read(), timeout=1.0)
+        finally:
+            writer.close()
+    except (OSError, asyncio.TimeoutError):
+        raise HTTPException(status_code=503, detail="Logger metrics unavailable")
+    return Response(
+        data,
+        media_type="text/plain; version=0.0.4",
+        headers={"Cache-Control": "no-cache"},
+    )
 
 
 app.mount(
@@ -0,0 +1,15 @@
+#  Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+from sqlmodel import Field, SQLModel
+
+from .scale import scaled
+
+
+class Alert(SQLModel, table=True):
+    alert_id: int = Field(primary_key=True)
+    rule: str
+    signal: str
+    start_time: int
+    end_time: int | None
+    value: float = scaled("value")
+    threshold: float = scaled("threshold")
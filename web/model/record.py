@@ -2,28 +2,36 @@
 
 from sqlmodel import Field, SQLModel
 
+from .scale import scaled
+
 
 class RecordBase(SQLModel):
     start_time: int = Field(primary_key=True)
     end_time: int = Field(primary_key=True)
-    start_mileage: float
-    end_mileage: float
+    start_mileage: float = scaled("start_mileage")
+    end_mileage: float = scaled("end_mileage")
     dist: int
     fuel: int
-    engine_speed: float
-    engine_speed_max: float
-    vehicle_speed_min: float
-    vehicle_speed_max: float
-    coolant_temp: float
-    outside_temp: float
-    oil_temp: float
-    oil_level: float
-    fuel_level: float
-    fuel_range: float
-    fuel_cons_min: float
-    fuel_cons_max: float
+    engine_speed: float = scaled("engine_speed")
+    engine_speed_max: float = scaled("engine_speed_max")
+    vehicle_speed_min: float = scaled("vehicle_speed_min")
+    vehicle_speed_max: float = scaled("vehicle_speed_max")
+    coolant_temp: float = scaled("coolant_temp")
+    outside_temp: float = scaled("outside_temp")
+    oil_temp: float = scaled("oil_temp")
+    oil_level: float = scaled("oil_level")
+    fuel_level: float = scaled("fuel_level")
+    fuel_range: float = scaled("fuel_range")
+    fuel_cons_min: float = scaled("fuel_cons_min")
+    fuel_cons_max: float = scaled("fuel_cons_max")
     trip_id: int | None = Field(default=None)
 
 
 class Record(RecordBase, table=True):
     pass
+
+
+RECORD_COLUMNS = tuple(RecordBase.model_fields)
+RECORD_COLUMNAR = tuple(
+    (column, "i" if column in ("dist", "fuel") else "d") for column in RECORD_COLUMNS
+)
@@ -0,0 +1,44 @@
+#  Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+import os
+import re
+from pathlib import Path
+
+from sqlalchemy import Integer
+from sqlalchemy.types import TypeDecorator
+from sqlmodel import Field
+
+# the logger stores these columns as round(value * scale) - see src/db_scale.h
+SCALE_HEADER = Path(
+    os.environ.get("DB_SCALE_HEADER", Path(__file__).parents[2] / "src" / "db_scale.h")
+)
+SCALES: dict[str, int] = {
+    column: int(scale)
+    for column, scale in re.findall(r"X\((\w+),\s*(\d+)\)", SCALE_HEADER.read_text())
+}
+
+
+class Scaled(TypeDecorator):
+    impl = Integer
+    cache_ok = True
+
+    def __init__(self, scale: int):
+        super().__init__()
+        self.scale = scale
+
+    def process_bind_param(self, value, dialect):
+        return None if value is None else round(value * self.scale)
+
+    def process_result_value(self, value, dialect):
+        return None if value is None else value / self.scale
+
+
+def scaled(column: str, **kwargs):
+    return Field(sa_type=Scaled(SCALES[column]), **kwargs)
+
+
+def column_sql(column: str) -> str:
+    # for raw queries, which bypass the column types
+    if column not in SCALES:
+        return column
+    return f"{column} / {SCALES[column]}.0 AS {column}"
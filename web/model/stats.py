@@ -0,0 +1,18 @@
+#  Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+from typing import Literal
+
+from sqlmodel import Field, SQLModel
+
+StatsPeriod = Literal["day", "week", "month", "year"]
+
+
+class TripStats(SQLModel, table=True):
+    __tablename__ = "trip_stats"
+
+    period: str = Field(primary_key=True)
+    period_start: int = Field(primary_key=True)
+    trips: int
+    time: int
+    dist: int
+    fuel: int
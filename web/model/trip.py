@@ -2,6 +2,8 @@
 
 from sqlmodel import Field, SQLModel
 
+from .scale import scaled
+
 
 class TripBase(SQLModel):
     time: int
@@ -9,27 +11,27 @@ class TripBase(SQLModel):
     fuel: int
     start_time: int
     end_time: int
-    start_mileage: float
-    end_mileage: float
-    engine_speed_max: float
-    vehicle_speed_max: float
-    coolant_temp_avg: float
-    coolant_temp_min: float
-    coolant_temp_max: float
-    outside_temp_avg: float
-    outside_temp_min: float
-    outside_temp_max: float
-    oil_temp_avg: float
-    oil_temp_min: float
-    oil_temp_max: float
-    oil_level_min: float
-    oil_level_max: float
-    fuel_level_min: float
-    fuel_level_max: float
-    fuel_range_min: float
-    fuel_range_max: float
-    fuel_cons_min: float
-    fuel_cons_max: float
+    start_mileage: float = scaled("start_mileage")
+    end_mileage: float = scaled("end_mileage")
+    engine_speed_max: float = scaled("engine_speed_max")
+    vehicle_speed_max: float = scaled("vehicle_speed_max")
+    coolant_temp_avg: float = scaled("coolant_temp_avg")
+    coolant_temp_min: float = scaled("coolant_temp_min")
+    coolant_temp_max: float = scaled("coolant_temp_max")
+    outside_temp_avg: float = scaled("outside_temp_avg")
+    outside_temp_min: float = scaled("outside_temp_min")
+    outside_temp_max: float = scaled("outside_temp_max")
+    oil_temp_avg: float = scaled("oil_temp_avg")
+    oil_temp_min: float = scaled("oil_temp_min")
+    oil_temp_max: float = scaled("oil_temp_max")
+    oil_level_min: float = scaled("oil_level_min")
+    oil_level_max: float = scaled("oil_level_max")
+    fuel_level_min: float = scaled("fuel_level_min")
+    fuel_level_max: float = scaled("fuel_level_max")
+    fuel_range_min: float = scaled("fuel_range_min")
+    fuel_range_max: float = scaled("fuel_range_max")
+    fuel_cons_min: float = scaled("fuel_cons_min")
+    fuel_cons_max: float = scaled("fuel_cons_max")
 
 
 class Trip(TripBase, table=True):
@@ -38,3 +40,9 @@ class Trip(TripBase, table=True):
 
 class TripNoId(TripBase):
     trip_id: int | None
+
+
+class TripCurrent(TripBase, table=True):
+    __tablename__ = "trip_current"
+
+    trip_id: int = Field(primary_key=True)
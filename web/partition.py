@@ -0,0 +1,104 @@
+#  Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+import os
+from collections import OrderedDict
+from pathlib import Path
+
+from sqlmodel import Session
+
+from .db import db_mmap_size, sqlite_file_name
+
+# partitions attached to a single pooled connection (SQLite allows 10 by default)
+partition_attach_max = int(os.environ.get("PARTITION_ATTACH_MAX", "8"))
+partition_dir = Path(sqlite_file_name).parent
+
+
+def partitions(
+    session: Session, start: int = None, end: int = None, descending: bool = False
+) -> list[tuple[str, str, bool]]:
+    """
+    List (name, file, closed) of record partitions that may hold records
+    of the [start, end) time range, in time order.
+    """
+    # the current partition has no time range yet, so it's always included
+    sql = (
+        "SELECT name, file, end_time IS NOT NULL FROM record_partition "
+        "WHERE (start_time IS NULL OR ?1 IS NULL OR start_time < ?1) "
+        "AND (end_time IS NULL OR ?2 IS NULL OR end_time > ?2) "
+        f"ORDER BY name {'DESC' if descending else 'ASC'}"
+    )
+    return session.connection().exec_driver_sql(sql, (end, start)).all()
+
+
+def attach(session: Session, name: str, file: str, closed: bool) -> str:
+    """
+    Attach a partition to the session's connection, if not attached yet.
+    Return its schema name.
+    """
+    dbapi_conn = session.connection().connection
+    attached: OrderedDict[str, bool] = dbapi_conn.info.setdefault(
+        "partitions", OrderedDict()
+    )
+    schema = "p_" + "".join(c if c.isalnum() else "_" for c in name)
+    if attached.get(schema) == closed:
+        attached.move_to_end(schema)
+        return schema
+
+    cursor = dbapi_conn.cursor()
+    if schema in attached:
+        # closed since attached (and no longer in WAL mode) - reopen it
+        cursor.execute(f"DETACH DATABASE {schema}")
+        del attached[schema]
+    while len(attached) >= partition_attach_max:
+        old_schema, _ = attached.popitem(last=False)
+        cursor.execute(f"DETACH DATABASE {old_schema}")
+    # not immutable - closed partitions are still rewritten when rebuilding trips
+    cursor.execute(
+        f"ATTACH DATABASE ? AS {schema}",
+        (f"file:{partition_dir / file}?mode=ro",),
+    )
+    cursor.execute(f"PRAGMA {schema}.mmap_size = {db_mmap_size}")
+    cursor.close()
+    attached[schema] = closed
+    return schema
+
+
+def select_records(
+    session: Session,
+    columns: str,
+    where: str,
+    params: list,
+    start: int = None,
+    end: int = None,
+    descending: bool = False,
+    limit: int = None,
+) -> list:
+    """
+    Run "SELECT columns FROM record WHERE where ORDER BY start_time" on the
+    partitions of the [start, end) time range, until 'limit' rows are read.
+    """
+    order = "DESC" if descending else "ASC"
+    rows = []
+    for name, file, closed in partitions(session, start, end, descending):
+        schema = attach(session, name, file, closed)
+        sql = f"SELECT {columns} FROM {schema}.record WHERE {where} ORDER BY start_time {order}"
+        args = list(params)
+        if limit is not None:
+            sql += " LIMIT ?"
+            args.append(limit - len(rows))
+        rows += session.connection().exec_driver_sql(sql, tuple(args)).all()
+        # partitions are in time order, so the following ones can't hold earlier rows
+        if limit is not None and len(rows) >= limit:
+            break
+    return rows
+
+
+def trip_range(session: Session, trip_id: int) -> tuple[int, int] | tuple[None, None]:
+    row = (
+        session.connection()
+        .exec_driver_sql(
+            "SELECT start_time, end_time + 1 FROM trip WHERE trip_id = ?", (trip_id,)
+        )
+        .first()
+    )
+    return tuple(row) if row else (None, None)
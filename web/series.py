@@ -0,0 +1,112 @@
+#  Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+from typing import Callable, Sequence
+
+# metrics computed from multiple record columns
+DERIVED_METRICS: dict[str, tuple[tuple[str, ...], Callable[..., float]]] = {
+    # cm/ms -> km/h
+    "speed": (
+        ("dist", "start_time", "end_time"),
+        lambda dist, start, end: dist / max(end - start, 1) * 36.0,
+    ),
+    # mm³/cm -> l/100 km
+    "fuel_cons": (
+        ("fuel", "dist"),
+        lambda fuel, dist: fuel * 10.0 / max(dist, 1),
+    ),
+}
+
+# metrics read directly from a record column
+RECORD_METRICS = (
+    "engine_speed",
+    "engine_speed_max",
+    "vehicle_speed_min",
+    "vehicle_speed_max",
+    "coolant_temp",
+    "outside_temp",
+    "oil_temp",
+    "oil_level",
+    "fuel_level",
+    "fuel_range",
+    "fuel_cons_min",
+    "fuel_cons_max",
+)
+
+SERIES_METRICS = (*DERIVED_METRICS.keys(), *RECORD_METRICS)
+
+
+def metric_columns(metrics: Sequence[str]) -> list[str]:
+    columns = ["start_time"]
+    for metric in metrics:
+        needed = DERIVED_METRICS[metric][0] if metric in DERIVED_METRICS else (metric,)
+        columns += [column for column in needed if column not in columns]
+    return columns
+
+
+def metric_values(metric: str, columns: list[str], rows: Sequence[tuple]) -> list[float]:
+    if metric in DERIVED_METRICS:
+        needed, func = DERIVED_METRICS[metric]
+        indexes = [columns.index(column) for column in needed]
+        return [func(*(row[i] for i in indexes)) for row in rows]
+    index = columns.index(metric)
+    return [row[index] for row in rows]
+
+
+def lttb(x: Sequence[float], y: Sequence[float], threshold: int) -> list[int]:
+    """
+    Largest-Triangle-Three-Buckets downsampling.
+    Return indexes of the points to keep (always including the first and last one).
+    """
+    count = len(x)
+    if threshold >= count or threshold < 3:
+        return list(range(count))
+
+    indexes = [0]
+    bucket_size = (count - 2) / (threshold - 2)
+    a = 0
+    for i in range(threshold - 2):
+        # average point of the next bucket
+        next_start = int((i + 1) * bucket_size) + 1
+        next_end = min(int((i + 2) * bucket_size) + 1, count)
+        avg_x = sum(x[next_start:next_end]) / (next_end - next_start)
+        avg_y = sum(y[next_start:next_end]) / (next_end - next_start)
+        # choose the point of this bucket forming the largest triangle
+        start = int(i * bucket_size) + 1
+        end = int((i + 1) * bucket_size) + 1
+        max_area = -1.0
+        max_index = start
+        for j in range(start, end):
+            area = abs(
+                (x[a] - avg_x) * (y[j] - y[a]) - (x[a] - x[j]) * (avg_y - y[a])
+            )
+            if area > max_area:
+                max_area = area
+                max_index = j
+        indexes.append(max_index)
+        a = max_index
+    indexes.append(count - 1)
+    return indexes
+
+
+def downsample(
+    metrics: Sequence[str],
+    columns: list[str],
+    rows: Sequence[tuple],
+    points: int,
+) -> dict:
+    """
+    Downsample every metric separately and merge the chosen points,
+    so that all metrics share a single time axis.
+    """
+    t = [row[0] for row in rows]
+    values = {metric: metric_values(metric, columns, rows) for metric in metrics}
+    threshold = max(points // max(len(metrics), 1), 3)
+    keep = set()
+    for metric in metrics:
+        keep.update(lttb(t, values[metric], threshold))
+    keep = sorted(keep)
+    return dict(
+        count=len(rows),
+        t=[t[i] for i in keep],
+        values={metric: [values[metric][i] for i in keep] for metric in metrics},
+    )
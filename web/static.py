@@ -0,0 +1,118 @@
+#  Copyright (c) Kuba Szczodrzyński 2026-10-19.
+
+import mimetypes
+import os
+import stat
+from hashlib import sha1
+
+import anyio
+from fastapi.staticfiles import StaticFiles
+from starlette.datastructures import Headers
+from starlette.responses import FileResponse, Response
+from starlette.staticfiles import NotModifiedResponse
+
+# preferred first; files are precompressed by web/frontend/scripts/compress.js
+ENCODINGS = (("br", ".br"), ("gzip", ".gz"))
+# files with a content hash in their name never change
+IMMUTABLE_PREFIX = "static/"
+IMMUTABLE_CACHE = "public, max-age=31536000, immutable"
+
+
+def accepted_encodings(scope) -> set[str]:
+    result = set()
+    for item in Headers(scope=scope).get("accept-encoding", "").split(","):
+        name, _, params = item.strip().partition(";")
+        if params.replace(" ", "") in ("q=0", "q=0.0", "q=0.00", "q=0.000"):
+            continue
+        result.add(name.strip().lower())
+    return result
+
+
+class SPAStaticFiles(StaticFiles):
+    """
+    Serves the frontend build, using precompressed files if the client accepts them.
+    Unknown paths are served index.html, which is kept in memory.
+    "no-cache" files are revalidated with ETag/If-None-Match (or Last-Modified).
+    """
+
+    def __init__(self, *args, **kwargs):
+        super().__init__(*args, **kwargs)
+        # encoding -> (content, ETag)
+        self.index: dict[str, tuple[bytes, str]] | None = None
+
+    def conditional(self, response: Response, scope) -> Response:
+        if self.is_not_modified(response.headers, Headers(scope=scope)):
+            return NotModifiedResponse(response.headers)
+        return response
+
+    async def get_response(self, path: str, scope) -> Response:
+        if path in ("", ".", "index.html"):
+            return self.index_response(scope)
+        full_path, stat_result = await anyio.to_thread.run_sync(self.lookup_path, path)
+        if not stat_result or not stat.S_ISREG(stat_result.st_mode):
+            # let the frontend router handle it
+            return self.index_response(scope)
+
+        headers = {"Vary": "Accept-Encoding"}
+        if path.startswith(IMMUTABLE_PREFIX):
+            headers["Cache-Control"] = IMMUTABLE_CACHE
+        else:
+            headers["Cache-Control"] = "no-cache"
+        media_type = mimetypes.guess_type(path)[0] or "application/octet-stream"
+
+        accepted = accepted_encodings(scope)
+        for encoding, suffix in ENCODINGS:
+            if encoding not in accepted:
+                continue
+            try:
+                encoded_stat = os.stat(full_path + suffix)
+            except OSError:
+                continue
+            headers["Content-Encoding"] = encoding
+            # the ETag is derived from the stat of the precompressed file, so it differs per encoding
+            response = FileResponse(
+                full_path + suffix,
+                stat_result=encoded_stat,
+                headers=headers,
+                media_type=media_type,
+            )
+            return self.conditional(response, scope)
+        response = FileResponse(
+            full_path,
+            stat_result=stat_result,
+            headers=headers,
+            media_type=media_type,
+        )
+        return self.conditional(response, scope)
+
+    def load_index(self) -> dict[str, tuple[bytes, str]]:
+        index = {}
+        full_path, stat_result = self.lookup_path("index.html")
+        if not stat_result:
+            return index
+        files = [("identity", full_path)]
+        for encoding, suffix in ENCODINGS:
+            if os.path.isfile(full_path + suffix):
+                files.append((encoding, full_path + suffix))
+        for encoding, path in files:
+            with open(path, "rb") as f:
+                content = f.read()
+            index[encoding] = (content, f'"{sha1(content).hexdigest()[:16]}"')
+        return index
+
+    def index_response(self, scope) -> Response:
+        if self.index is None:
+            self.index = self.load_index()
+        if not self.index:
+            return Response("Not Found", status_code=404)
+        headers = {"Vary": "Accept-Encoding", "Cache-Control": "no-cache"}
+        accepted = accepted_encodings(scope)
+        encoding = "identity"
+        for name, _ in ENCODINGS:
+            if name in accepted and name in self.index:
+                encoding = name
+                headers["Content-Encoding"] = name
+                break
+        content, headers["ETag"] = self.index[encoding]
+        response = Response(content, headers=headers, media_type="text/html")
+        return self.conditional(response, scope)